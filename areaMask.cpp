@@ -0,0 +1,442 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "areaMask.hpp"
+
+
+//  An edge in cell coordinates (area row r is centered at y = r + 0.5, column j at x = j + 0.5).
+
+typedef struct
+{
+  double        y_top;
+  double        y_bottom;
+  double        x_top;                      //  x at y_top
+  double        dxdy;                       //  Change in x per unit of y
+  int32_t       dir;                        //  1 if the edge goes up, -1 if it goes down (for the winding number)
+} AREA_EDGE;
+
+
+typedef struct
+{
+  double        x;
+  int32_t       dir;
+} AREA_CROSS;
+
+
+
+static int32_t compare_edges (const void *a, const void *b)
+{
+  double ya = ((AREA_EDGE *) a)->y_top, yb = ((AREA_EDGE *) b)->y_top;
+
+  if (ya > yb) return (-1);
+  if (ya < yb) return (1);
+  return (0);
+}
+
+
+
+static int32_t compare_crosses (const void *a, const void *b)
+{
+  double xa = ((AREA_CROSS *) a)->x, xb = ((AREA_CROSS *) b)->x;
+
+  if (xa < xb) return (-1);
+  if (xa > xb) return (1);
+  return (0);
+}
+
+
+
+//  Append a ring to the polygon.
+
+static uint8_t add_ring (AREA_POLYGON *poly, double *x, double *y, int32_t count)
+{
+  int32_t *ring_start = (int32_t *) realloc (poly->ring_start, (poly->ring_count + 2) * sizeof (int32_t));
+  if (ring_start == NULL) return (NVFalse);
+  poly->ring_start = ring_start;
+
+  double *new_x = (double *) realloc (poly->x, ((int64_t) poly->vertex_count + count) * sizeof (double));
+  if (new_x == NULL) return (NVFalse);
+  poly->x = new_x;
+
+  double *new_y = (double *) realloc (poly->y, ((int64_t) poly->vertex_count + count) * sizeof (double));
+  if (new_y == NULL) return (NVFalse);
+  poly->y = new_y;
+
+
+  memcpy (&poly->x[poly->vertex_count], x, count * sizeof (double));
+  memcpy (&poly->y[poly->vertex_count], y, count * sizeof (double));
+
+  for (int32_t i = 0 ; i < count ; i++)
+    {
+      if (!poly->vertex_count && !i)
+        {
+          poly->mbr.min_x = poly->mbr.max_x = x[i];
+          poly->mbr.min_y = poly->mbr.max_y = y[i];
+        }
+
+      poly->mbr.min_x = qMin (poly->mbr.min_x, x[i]);
+      poly->mbr.max_x = qMax (poly->mbr.max_x, x[i]);
+      poly->mbr.min_y = qMin (poly->mbr.min_y, y[i]);
+      poly->mbr.max_y = qMax (poly->mbr.max_y, y[i]);
+    }
+
+  poly->ring_start[poly->ring_count] = poly->vertex_count;
+  poly->vertex_count += count;
+  poly->ring_count++;
+  poly->ring_start[poly->ring_count] = poly->vertex_count;
+
+  return (NVTrue);
+}
+
+
+
+//  Every part of every shape in a polygon or polyline shape file.
+
+static uint8_t read_shape_file (char *area_file, AREA_POLYGON *poly)
+{
+  SHPHandle shpHandle;
+  int32_t type, numShapes;
+  double minBounds[4], maxBounds[4];
+
+
+  if ((shpHandle = SHPOpen (area_file, "rb")) == NULL) return (NVFalse);
+
+  SHPGetInfo (shpHandle, &numShapes, &type, minBounds, maxBounds);
+
+  if (type != SHPT_POLYGON && type != SHPT_POLYGONZ && type != SHPT_POLYGONM &&
+      type != SHPT_ARC && type != SHPT_ARCZ && type != SHPT_ARCM)
+    {
+      SHPClose (shpHandle);
+      errno = EINVAL;
+      return (NVFalse);
+    }
+
+
+  for (int32_t i = 0 ; i < numShapes ; i++)
+    {
+      SHPObject *shape = SHPReadObject (shpHandle, i);
+
+      if (shape == NULL) continue;
+
+      for (int32_t p = 0 ; p < qMax (shape->nParts, 1) ; p++)
+        {
+          int32_t start = 0, end = shape->nVertices;
+
+          if (shape->nParts)
+            {
+              start = shape->panPartStart[p];
+              if (p + 1 < shape->nParts) end = shape->panPartStart[p + 1];
+            }
+
+          if (end - start >= 3 && !add_ring (poly, &shape->padfX[start], &shape->padfY[start], end - start))
+            {
+              SHPDestroyObject (shape);
+              SHPClose (shpHandle);
+              return (NVFalse);
+            }
+        }
+
+      SHPDestroyObject (shape);
+    }
+
+  SHPClose (shpHandle);
+
+  if (!poly->ring_count)
+    {
+      errno = EINVAL;
+      return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+/*!
+    Read all of the rings of an area file.  Returns NVFalse (with errno set) if the file can't be read or has no
+    usable rings.  An area file with fewer than three points is treated as the rectangle get_area_mbr returns.
+*/
+
+uint8_t area_polygon_read (char *area_file, AREA_POLYGON *poly)
+{
+  memset (poly, 0, sizeof (AREA_POLYGON));
+
+  int32_t len = strlen (area_file);
+
+  if (len > 4 && (!strcmp (&area_file[len - 4], ".shp") || !strcmp (&area_file[len - 4], ".SHP")))
+    {
+      if (read_shape_file (area_file, poly)) return (NVTrue);
+
+      area_polygon_free (poly);
+      return (NVFalse);
+    }
+
+
+  //  get_area_mbr has its own limit (the ISS-60 and generic area formats are small).
+
+  double polygon_x[200], polygon_y[200];
+  int32_t count = 0;
+  NV_F64_XYMBR mbr;
+
+  if (!get_area_mbr (area_file, &count, polygon_x, polygon_y, &mbr)) return (NVFalse);
+
+  if (count < 3)
+    {
+      polygon_x[0] = polygon_x[3] = mbr.min_x;
+      polygon_x[1] = polygon_x[2] = mbr.max_x;
+      polygon_y[0] = polygon_y[1] = mbr.min_y;
+      polygon_y[2] = polygon_y[3] = mbr.max_y;
+      count = 4;
+    }
+
+  if (!add_ring (poly, polygon_x, polygon_y, count))
+    {
+      area_polygon_free (poly);
+      return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+void area_polygon_free (AREA_POLYGON *poly)
+{
+  free (poly->ring_start);
+  free (poly->x);
+  free (poly->y);
+
+  memset (poly, 0, sizeof (AREA_POLYGON));
+}
+
+
+
+/*!
+    Build the per row span index of the polygon for the area window.  min_x, min_y and the bin sizes are the
+    lower left corner and cell size of the window, in the same units as the polygon.  Returns NVFalse if we
+    couldn't get the memory.
+*/
+
+uint8_t area_mask_open (AREA_MASK *mask, AREA_POLYGON *poly, double min_x, double min_y, double x_bin_size,
+                        double y_bin_size, int32_t width, int32_t height)
+{
+  AREA_EDGE *edges = NULL;
+  AREA_CROSS *cross = NULL;
+  int32_t *active = NULL, edge_count = 0;
+  int64_t span_max = 0;
+
+
+  memset (mask, 0, sizeof (AREA_MASK));
+
+  mask->width = width;
+  mask->height = height;
+
+  mask->row_first = (int64_t *) calloc (height, sizeof (int64_t));
+  mask->row_spans = (int32_t *) calloc (height, sizeof (int32_t));
+  edges = (AREA_EDGE *) calloc (qMax (poly->vertex_count, 1), sizeof (AREA_EDGE));
+
+  if (mask->row_first == NULL || mask->row_spans == NULL || edges == NULL)
+    {
+      free (edges);
+      area_mask_close (mask);
+      return (NVFalse);
+    }
+
+
+  //  Edge list.  Horizontal edges never cross a row center and edges that are entirely above or below the
+  //  window never cross one of our row centers so they are left out.
+
+  for (int32_t r = 0 ; r < poly->ring_count ; r++)
+    {
+      int32_t first = poly->ring_start[r], last = poly->ring_start[r + 1] - 1;
+
+      for (int32_t i = first ; i <= last ; i++)
+        {
+          int32_t k = (i == last) ? first : i + 1;
+
+          double x0 = (poly->x[i] - min_x) / x_bin_size, y0 = (poly->y[i] - min_y) / y_bin_size;
+          double x1 = (poly->x[k] - min_x) / x_bin_size, y1 = (poly->y[k] - min_y) / y_bin_size;
+
+          if (y0 == y1 || qMax (y0, y1) <= 0.5 || qMin (y0, y1) > height - 0.5) continue;
+
+          AREA_EDGE *edge = &edges[edge_count++];
+
+          edge->dxdy = (x1 - x0) / (y1 - y0);
+
+          if (y0 > y1)
+            {
+              edge->y_top = y0;
+              edge->x_top = x0;
+              edge->y_bottom = y1;
+              edge->dir = -1;
+            }
+          else
+            {
+              edge->y_top = y1;
+              edge->x_top = x1;
+              edge->y_bottom = y0;
+              edge->dir = 1;
+            }
+        }
+    }
+
+  qsort (edges, edge_count, sizeof (AREA_EDGE), compare_edges);
+
+  active = (int32_t *) calloc (qMax (edge_count, 1), sizeof (int32_t));
+  cross = (AREA_CROSS *) calloc (qMax (edge_count, 1), sizeof (AREA_CROSS));
+
+  if (active == NULL || cross == NULL)
+    {
+      free (edges);
+      free (active);
+      free (cross);
+      area_mask_close (mask);
+      return (NVFalse);
+    }
+
+
+  //  Sweep down from the top row.  An edge covers the row center y if y_bottom <= y < y_top, which counts a
+  //  vertex that is shared by two edges exactly once.
+
+  int32_t next_edge = 0, active_count = 0;
+
+  for (int32_t row = height - 1 ; row >= 0 ; row--)
+    {
+      double y = (double) row + 0.5;
+      int32_t count = 0;
+
+      while (next_edge < edge_count && edges[next_edge].y_top > y) active[active_count++] = next_edge++;
+
+      for (int32_t i = 0 ; i < active_count ; i++)
+        {
+          AREA_EDGE *edge = &edges[active[i]];
+
+          if (edge->y_bottom > y)
+            {
+              active[i--] = active[--active_count];
+              continue;
+            }
+
+          cross[count].x = edge->x_top + (y - edge->y_top) * edge->dxdy;
+          cross[count++].dir = edge->dir;
+        }
+
+      qsort (cross, count, sizeof (AREA_CROSS), compare_crosses);
+
+
+      //  Spans are where the winding number isn't zero.  Cell j is inside if its center is.
+
+      mask->row_first[row] = mask->span_count;
+
+      int32_t winding = 0;
+      double span_x = 0.0;
+
+      for (int32_t i = 0 ; i < count ; i++)
+        {
+          int32_t was = winding;
+
+          winding += cross[i].dir;
+
+          if (!was && winding)
+            {
+              span_x = cross[i].x;
+            }
+          else if (was && !winding)
+            {
+              int32_t start = (int32_t) qBound (0.0, ceil (span_x - 0.5), (double) width);
+              int32_t end = (int32_t) qBound (0.0, ceil (cross[i].x - 0.5), (double) width);
+
+              if (end <= start) continue;
+
+              if (mask->span_count == span_max)
+                {
+                  span_max = qMax (span_max * 2, (int64_t) 1024);
+
+                  int32_t *spans = (int32_t *) realloc (mask->spans, span_max * 2 * sizeof (int32_t));
+
+                  if (spans == NULL)
+                    {
+                      free (edges);
+                      free (active);
+                      free (cross);
+                      area_mask_close (mask);
+                      return (NVFalse);
+                    }
+
+                  mask->spans = spans;
+                }
+
+              mask->spans[mask->span_count * 2] = start;
+              mask->spans[mask->span_count * 2 + 1] = end;
+              mask->span_count++;
+              mask->row_spans[row]++;
+            }
+        }
+    }
+
+  free (edges);
+  free (active);
+  free (cross);
+
+  return (NVTrue);
+}
+
+
+
+//  Set fill[j] to 1 for the cells of area row (0 is the bottom, southern, row of the window) that are inside the
+//  area and 0 for the rest.
+
+void area_mask_row (AREA_MASK *mask, int32_t row, uint8_t *fill)
+{
+  memset (fill, 0, mask->width);
+
+  int32_t *span = &mask->spans[mask->row_first[row] * 2];
+
+  for (int32_t i = 0 ; i < mask->row_spans[row] ; i++, span += 2) memset (&fill[span[0]], 1, span[1] - span[0]);
+}
+
+
+
+void area_mask_close (AREA_MASK *mask)
+{
+  free (mask->row_first);
+  free (mask->row_spans);
+  free (mask->spans);
+
+  memset (mask, 0, sizeof (AREA_MASK));
+}
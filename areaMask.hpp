@@ -0,0 +1,90 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef AREAMASK_H
+#define AREAMASK_H
+
+#include "bagGeotiffDef.hpp"
+
+
+/*!
+    Area file polygons and the mask built from them.
+
+    An AREA_POLYGON is every ring of the area file.  For a shape file that is every part of every shape (outer
+    rings, holes, islands, and polylines, which are closed), with no limit on the number of vertices.  Other area
+    files (.are, .afs) are read with get_area_mbr.
+
+    The AREA_MASK is built once for the area window.  The edges of all of the rings are swept from the top row
+    down with an active edge table and the inside spans of each row (nonzero winding, so shape file holes, which
+    go the other way around, are left out) are saved in a per row interval index.  Getting the fill flags for a
+    row is then just clearing the row and setting its spans, no matter how many vertices the area has, and the
+    rows can be asked for in any order from any thread.
+*/
+
+
+typedef struct
+{
+  int32_t       ring_count;
+  int32_t       *ring_start;                //  ring_count + 1 entries, ring i is vertices ring_start[i] to ring_start[i + 1] - 1
+  int32_t       vertex_count;
+  double        *x;
+  double        *y;
+  NV_F64_XYMBR  mbr;
+} AREA_POLYGON;
+
+
+typedef struct
+{
+  int32_t       width;                      //  Area window size in cells
+  int32_t       height;
+  int64_t       *row_first;                 //  First span of each area row (row 0 is the southern row)
+  int32_t       *row_spans;                 //  Number of spans in each area row
+  int32_t       *spans;                     //  Start and end (exclusive) column of each span
+  int64_t       span_count;
+} AREA_MASK;
+
+
+uint8_t area_polygon_read (char *area_file, AREA_POLYGON *poly);
+void area_polygon_free (AREA_POLYGON *poly);
+uint8_t area_mask_open (AREA_MASK *mask, AREA_POLYGON *poly, double min_x, double min_y, double x_bin_size,
+                        double y_bin_size, int32_t width, int32_t height);
+void area_mask_row (AREA_MASK *mask, int32_t row, uint8_t *fill);
+void area_mask_close (AREA_MASK *mask);
+
+
+#endif
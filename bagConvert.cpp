@@ -0,0 +1,1026 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "bagConvert.hpp"
+
+
+//  Set the conversion parameters to the same defaults that envin uses when there is no settings file.
+
+void set_convert_defaults (CONVERT_PARAMS *params)
+{
+  memset (params, 0, sizeof (CONVERT_PARAMS));
+
+  params->transparent = NVFalse;
+  params->caris = NVFalse;
+  params->restart = NVTrue;
+  params->azimuth = 30.0;
+  params->elevation = 30.0;
+  params->exaggeration = 2.5;
+  params->saturation = 1.0;
+  params->value = 0.0;
+  params->start_hsv = 0.0;
+  params->end_hsv = 240.0;
+  params->minmax_source = MINMAX_SPILL;
+  params->stats_sidecar = NVTrue;
+  params->spill_memory = 1024;
+  params->threads = 0;
+  params->block_reads = NVTrue;
+  params->chunk_cache = 16;
+  params->pipeline_memory = 256;
+  params->fast_shade = NVFalse;
+  params->lut_shade = NVFalse;
+
+  set_tiff_defaults (&params->tiff);
+  params->progress = NULL;
+  params->user_data = NULL;
+}
+
+
+
+//  Set the sun shading options.  These must match what display_sample_data (imagePage.cpp) does for the sample.
+
+void set_convert_sunopts (CONVERT_PARAMS *params, SUN_OPT *sunopts)
+{
+  sunopts->azimuth = params->azimuth;
+  sunopts->elevation = params->elevation;
+  sunopts->exag = params->exaggeration;
+  sunopts->power_cos = 1.0;
+  sunopts->num_shades = 50;
+  sunopts->min_shade = 0.0;
+  sunopts->sun = sun_unv (sunopts->azimuth, sunopts->elevation);
+}
+
+
+
+//  Everything that has to be cleaned up when bag_convert exits, whether it worked or not.
+
+typedef struct
+{
+  bagHandle     bag_handle;
+  uint8_t       bag_open;
+  CONVERT_SOURCE *source;
+  BAG_READER    reader;
+  uint8_t       reader_open;
+  uint8_t       *palette;
+  ROW_STORE     store;
+  AREA_POLYGON  area;
+  AREA_MASK     mask;
+  uint8_t       mask_open;
+  float         *halo;                      //  Last elevation row of the previous band
+  PIPELINE_BAND pipe[MAX_PIPELINE_BANDS];
+  int32_t       pipe_count;
+  QThreadPool   *pool;
+  TIFF_WRITER   writer;
+  int64_t       gdal_cache;                 //  GDAL cache size to put back when we're done, 0 if we didn't change it
+  SHADE_LUT     *shade_lut;                 //  Shade lookup table if params->lut_shade is set
+} CONVERT_WORK;
+
+
+
+static void convert_cleanup (CONVERT_WORK *work)
+{
+  tiff_writer_close (&work->writer);
+  if (work->pool) delete work->pool;
+
+  if (work->gdal_cache) GDALSetCacheMax64 (work->gdal_cache);
+
+  row_store_close (&work->store);
+
+  if (work->mask_open) area_mask_close (&work->mask);
+  area_polygon_free (&work->area);
+
+  if (work->reader_open) bag_reader_close (&work->reader);
+
+  free (work->halo);
+
+  for (int32_t i = 0 ; i < MAX_PIPELINE_BANDS ; i++)
+    {
+      free (work->pipe[i].rows);
+      free (work->pipe[i].fill);
+      free (work->pipe[i].pixels);
+    }
+
+  if (work->bag_open) bagFileClose (work->bag_handle);
+
+  free (work->palette);
+  free (work->shade_lut);
+
+  memset (work, 0, sizeof (CONVERT_WORK));
+}
+
+
+
+//  Close a partial GeoTIFF and get rid of it.  The writer doesn't make the COG from a partial file so in COG mode
+//  the only thing on disk is the temporary tiled file (NAME.cog.tmp).
+
+static void discard_output (CONVERT_WORK *work, char *name)
+{
+  int32_t mode = work->writer.options.mode;
+
+
+  tiff_writer_close (&work->writer);
+
+  if (mode == TIFF_COG)
+    {
+      char temp[1040];
+
+      snprintf (temp, sizeof (temp), "%s.cog.tmp", name);
+      remove (temp);
+    }
+  else
+    {
+      remove (name);
+    }
+}
+
+
+
+//  Read an elevation row of the output area from the BAG, using the chunk aligned BAG_READER if we have one.
+
+static uint8_t read_bag_row (CONVERT_WORK *work, int32_t row, int32_t x_start, int32_t y_start, int32_t width, float *data)
+{
+  if (work->source) return ((*work->source->read_row) (y_start + row, x_start, width, data, work->source->user_data));
+
+  if (work->reader_open) return (bag_reader_get_row (&work->reader, row, data));
+
+  return (bagReadRow (work->bag_handle, y_start + row, x_start, x_start + width - 1, Elevation, (void *) data) == BAG_SUCCESS);
+}
+
+
+
+//  Get an elevation row of the output area either from the row store (if it was filled in the min/max pass) or
+//  from the BAG.  The row is flipped to depth.
+
+static uint8_t read_area_row (CONVERT_WORK *work, int32_t row, int32_t x_start, int32_t y_start, int32_t width, float *data)
+{
+  if (work->store.height)
+    {
+      if (!row_store_get (&work->store, row, data)) return (NVFalse);
+    }
+  else
+    {
+      if (!read_bag_row (work, row, x_start, y_start, width, data)) return (NVFalse);
+    }
+
+  for (int32_t j = 0 ; j < width ; j++) data[j] = -data[j];
+
+  return (NVTrue);
+}
+
+
+
+//  What the pipeline stages share.  The queues pass band indices (into CONVERT_WORK.pipe) from the reader to the
+//  renderer (loaded), from the renderer to the writer (rendered), and from the writer back to the reader (empty).
+
+typedef struct
+{
+  CONVERT_WORK  *work;
+  int32_t       x_start;
+  int32_t       y_start;
+  int32_t       width;
+  int32_t       height;
+  int32_t       band_rows;
+  bandQueue     empty;
+  bandQueue     loaded;
+  bandQueue     rendered;
+  int32_t       read_error_row;             //  Area row that couldn't be read, -1 if none
+  BAG_STATS     *stats;                     //  Histogram to fill in for the sidecar, NULL if we already have one
+  STAGE_TIMES   *timing;                    //  Same as CONVERT_PARAMS.timing
+} CONVERT_PIPELINE;
+
+
+
+/*
+    Reader stage.  Output row k is shaded using area row height - 1 - k (the next row) and the row above it (the
+    current row).  For the first output row both are the top row.  Band row 0 is the current row for the first
+    output row in the band, which is the last next row of the previous band (the halo).
+*/
+
+static void reader_stage (void *user_data)
+{
+  CONVERT_PIPELINE *cp = (CONVERT_PIPELINE *) user_data;
+  CONVERT_WORK *work = cp->work;
+  int32_t width = cp->width, height = cp->height;
+  STAGE_CLOCK clock;
+
+
+  for (int32_t k0 = 0 ; k0 < height && cp->read_error_row < 0 ; k0 += cp->band_rows)
+    {
+      int32_t b = cp->empty.get ();
+
+      if (b < 0) break;
+
+      PIPELINE_BAND *band = &work->pipe[b];
+
+      band->first_row = k0;
+      band->num_rows = qMin (cp->band_rows, height - k0);
+
+      if (k0) memcpy (band->rows, work->halo, width * sizeof (float));
+
+      for (int32_t t = 0 ; t < band->num_rows ; t++)
+        {
+          int32_t row = height - 1 - (k0 + t);
+
+          if (cp->timing) stage_start (&clock);
+
+          if (!read_area_row (work, row, cp->x_start, cp->y_start, width, &band->rows[(int64_t) (t + 1) * width]))
+            {
+              cp->read_error_row = row;
+              break;
+            }
+
+          if (cp->timing)
+            {
+              stage_stop (cp->timing, STAGE_READ, &clock, width);
+              cp->timing->bytes_read += width * sizeof (float);
+            }
+
+          if (cp->stats) bag_stats_add_row (cp->stats, &band->rows[(int64_t) (t + 1) * width], width);
+        }
+
+      if (cp->read_error_row >= 0)
+        {
+          cp->empty.put (b);
+          break;
+        }
+
+      if (!k0) memcpy (band->rows, &band->rows[width], width * sizeof (float));
+
+      memcpy (work->halo, &band->rows[(int64_t) band->num_rows * width], width * sizeof (float));
+
+
+      //  Output row k0 + t is area row height - 1 - (k0 + t).
+
+      if (work->mask_open)
+        {
+          for (int32_t t = 0 ; t < band->num_rows ; t++)
+            area_mask_row (&work->mask, height - 1 - (k0 + t), &band->fill[(int64_t) t * width]);
+        }
+      else
+        {
+          memset (band->fill, 1, (int64_t) band->num_rows * width);
+        }
+
+
+      cp->loaded.put (b);
+    }
+
+  cp->loaded.close ();
+}
+
+
+
+//  Writer stage.  The bands come through in order so the TIFF_WRITER sees the rows from the top down.
+
+static void writer_stage (void *user_data)
+{
+  CONVERT_PIPELINE *cp = (CONVERT_PIPELINE *) user_data;
+  CONVERT_WORK *work = cp->work;
+  int32_t b;
+  STAGE_CLOCK clock;
+
+
+  while ((b = cp->rendered.get ()) >= 0)
+    {
+      PIPELINE_BAND *band = &work->pipe[b];
+
+      if (cp->timing) stage_start (&clock);
+
+      tiff_writer_put_rows (&work->writer, band->first_row, band->num_rows, band->pixels);
+
+      if (cp->timing)
+        {
+          int64_t cells = (int64_t) band->num_rows * cp->width;
+
+          stage_stop (cp->timing, STAGE_WRITE, &clock, cells);
+          cp->timing->bytes_written += cells * work->writer.bands;
+        }
+
+      cp->empty.put (b);
+    }
+}
+
+
+
+//  This is where the fun stuff happens.
+
+int32_t bag_convert (CONVERT_PARAMS *params, CONVERT_RESULT *result)
+{
+  int32_t             i, j, width, height, x_start, y_start, threads, band_rows;
+  float               min_val, max_val;
+  double              conversion_factor, mid_y_radians, x_bin_size_degrees, y_bin_size_degrees;
+  NV_F64_XYMBR        bag_mbr, mbr;
+  char                name[1024];
+  bagError            bagErr;
+  CONVERT_WORK        work;
+  RENDER_PARAMS       rp;
+  STAGE_TIMES         *timing = params->timing;
+  STAGE_CLOCK         run_clock, clock;
+
+
+  memset (result, 0, sizeof (CONVERT_RESULT));
+  memset (&work, 0, sizeof (CONVERT_WORK));
+
+  if (timing) stage_times_start (timing, &run_clock);
+
+
+  //  Set up the sun shading options and the packed palette (from the palette cache, paletteCache.cpp).  We don't
+  //  need the QColor array.
+
+  set_convert_sunopts (params, &rp.sunopts);
+
+  work.palette = (uint8_t *) malloc (PALETTE_COLORS * 4);
+
+  if (work.palette == NULL)
+    {
+      snprintf (result->error, sizeof (result->error), "Error allocating palette : %s", strerror (errno));
+      return (CONVERT_ALLOCATION_ERROR);
+    }
+
+  palette_get (params->saturation, params->value, params->start_hsv, params->end_hsv, work.palette);
+
+  rp.palette = work.palette;
+  rp.timing = timing;
+
+
+  //  Open the BAG file (unless we've been given something else to read).
+
+  int32_t data_cols, data_rows;
+  float bag_min, bag_max;
+
+  if (timing) stage_start (&clock);
+
+  if (params->source)
+    {
+      work.source = params->source;
+
+      data_cols = work.source->cols;
+      data_rows = work.source->rows;
+      x_bin_size_degrees = work.source->x_spacing;
+      y_bin_size_degrees = work.source->y_spacing;
+      bag_mbr.min_x = work.source->sw_x;
+      bag_mbr.min_y = work.source->sw_y;
+      bag_min = work.source->min_elevation;
+      bag_max = work.source->max_elevation;
+    }
+  else if ((bagErr = bagFileOpen (&work.bag_handle, BAG_OPEN_READONLY, (u8 *) params->bag_file)) != BAG_SUCCESS)
+    {
+      u8 *errstr;
+
+      if (bagGetErrorString (bagErr, &errstr) == BAG_SUCCESS)
+        {
+          snprintf (result->error, sizeof (result->error), "Error opening BAG file : %s", errstr);
+        }
+      else
+        {
+          snprintf (result->error, sizeof (result->error), "Error opening BAG file %s", params->bag_file);
+        }
+
+      convert_cleanup (&work);
+      return (CONVERT_BAG_OPEN_ERROR);
+    }
+
+  else
+    {
+      work.bag_open = NVTrue;
+
+      data_cols = bagGetDataPointer (work.bag_handle)->def.ncols;
+      data_rows = bagGetDataPointer (work.bag_handle)->def.nrows;
+      x_bin_size_degrees = bagGetDataPointer (work.bag_handle)->def.nodeSpacingX;
+      y_bin_size_degrees = bagGetDataPointer (work.bag_handle)->def.nodeSpacingY;
+      bag_mbr.min_x = bagGetDataPointer (work.bag_handle)->def.swCornerX;
+      bag_mbr.min_y = bagGetDataPointer (work.bag_handle)->def.swCornerY;
+      bag_min = bagGetDataPointer (work.bag_handle)->min_elevation;
+      bag_max = bagGetDataPointer (work.bag_handle)->max_elevation;
+    }
+
+  if (timing) stage_stop (timing, STAGE_OPEN, &clock, 0);
+
+  bag_mbr.max_x = bag_mbr.min_x + data_cols * x_bin_size_degrees;
+  bag_mbr.max_y = bag_mbr.min_y + data_rows * y_bin_size_degrees;
+
+
+  strcpy (name, params->output_file);
+
+  if (strlen (name) < 4 || strcmp (&name[strlen (name) - 4], ".tif")) strcat (name, ".tif");
+
+  strcpy (result->output_file, name);
+
+
+  x_start = 0;
+  y_start = 0;
+  width = data_cols;
+  height = data_rows;
+
+
+  //  Check for an area file.
+
+  mbr = bag_mbr;
+  if (params->area_file[0])
+    {
+      if (!area_polygon_read (params->area_file, &work.area))
+        {
+          snprintf (result->error, sizeof (result->error), "Error reading area file %s\nReason : %s", params->area_file,
+                    strerror (errno));
+          convert_cleanup (&work);
+          return (CONVERT_AREA_FILE_ERROR);
+        }
+
+      mbr = work.area.mbr;
+
+
+      if (mbr.min_y > bag_mbr.max_y || mbr.max_y < bag_mbr.min_y || mbr.min_x > bag_mbr.max_x || mbr.max_x < bag_mbr.min_x)
+        {
+          strcpy (result->error, "Specified area is completely outside of the BAG bounds!");
+          convert_cleanup (&work);
+          return (CONVERT_AREA_BOUNDS_ERROR);
+        }
+
+
+      //  Match to nearest cell
+
+      x_start = NINT ((mbr.min_x - bag_mbr.min_x) / x_bin_size_degrees);
+      y_start = NINT ((mbr.min_y - bag_mbr.min_y) / y_bin_size_degrees);
+      width = NINT ((mbr.max_x - mbr.min_x) / x_bin_size_degrees);
+      height = NINT ((mbr.max_y - mbr.min_y) / y_bin_size_degrees);
+
+
+      //  Adjust to BAG bounds if necessary
+
+      if (x_start < 0) x_start = 0;
+      if (y_start < 0) y_start = 0;
+      if (x_start + width > data_cols) width = data_cols - x_start;
+      if (y_start + height > data_rows) height = data_rows - y_start;
+
+
+      //  Redefine bounds
+
+      mbr.min_x = bag_mbr.min_x + x_start * x_bin_size_degrees;
+      mbr.min_y = bag_mbr.min_y + y_start * y_bin_size_degrees;
+      mbr.max_x = mbr.min_x + width * x_bin_size_degrees;
+      mbr.max_y = mbr.min_y + height * y_bin_size_degrees;
+    }
+
+
+  //  An area narrower or shorter than one cell (or an empty BAG) leaves us nothing to convert.
+
+  if (width <= 0 || height <= 0)
+    {
+      snprintf (result->error, sizeof (result->error), "Area to convert is %d columns by %d rows, nothing to convert!",
+                width, height);
+      convert_cleanup (&work);
+      return (CONVERT_AREA_BOUNDS_ERROR);
+    }
+
+  result->width = width;
+  result->height = height;
+  rp.width = width;
+
+
+  //  Mask out the cells that are in the area's bounding rectangle but outside of the area's rings.  If we can't
+  //  get the memory for the span index we render the whole rectangle the way we always have.
+
+  if (params->area_file[0])
+    {
+      work.mask_open = area_mask_open (&work.mask, &work.area, mbr.min_x, mbr.min_y, x_bin_size_degrees, y_bin_size_degrees,
+                                       width, height);
+      result->area_mask = work.mask_open;
+    }
+
+
+  //  Compute cell sizes for sunshading.
+
+  mid_y_radians = (bag_mbr.max_y - bag_mbr.min_y) * 0.0174532925199432957692;
+  conversion_factor = cos (mid_y_radians);
+  rp.x_cell_size = x_bin_size_degrees * 111120.0 * conversion_factor;
+  rp.y_cell_size = y_bin_size_degrees * 111120.0;
+
+
+  //  Use the row hillshade kernel only if it agrees with sunshade for these sun options and cell sizes.
+
+  rp.fast_shade = NVFalse;
+  if (params->fast_shade) rp.fast_shade = shade_row_check (&rp.sunopts, rp.x_cell_size, rp.y_cell_size, &result->shade_diff);
+
+  result->fast_shade = rp.fast_shade;
+  result->shade_level = shade_row_level ();
+
+
+  //  The shade lookup table is built once for these sun options and cell sizes.  It replaces both sunshade and the
+  //  row kernel.  If we can't get the memory for it we just go without.
+
+  rp.shade_lut = NULL;
+
+  if (params->lut_shade)
+    {
+      work.shade_lut = (SHADE_LUT *) malloc (sizeof (SHADE_LUT));
+
+      if (work.shade_lut != NULL)
+        {
+          if (timing) stage_start (&clock);
+
+          shade_lut_build (work.shade_lut, &rp.sunopts, rp.x_cell_size, rp.y_cell_size);
+
+          if (timing) stage_stop (timing, STAGE_SHADE, &clock, 0);
+
+          rp.shade_lut = work.shade_lut;
+        }
+    }
+
+  result->lut_shade = (rp.shade_lut != NULL);
+
+
+  //  Figure out how many render threads to use and how tall the bands are.  We want enough rows in a band to
+  //  keep all of the threads busy but we don't want the band buffers to get silly on really wide BAGs.
+
+  threads = params->threads;
+  if (threads <= 0) threads = QThread::idealThreadCount ();
+  if (threads <= 0) threads = 1;
+
+  int32_t bands = 3;
+  if (params->transparent) bands = 4;
+  rp.bands = bands;
+
+  TIFF_OPTIONS tiff = params->tiff;
+  if (params->caris) tiff.mode = TIFF_CARIS;
+
+
+  //  With a memory budget the fixed size buffers (the writer's tile row and overview buffers and the area mask)
+  //  come off the top and everything else is given a share of what's left (memoryPlan.cpp).
+
+  MEMORY_PLAN *plan = &result->memory;
+
+  plan->budget = (int64_t) params->memory_budget * 1048576;
+  plan->bytes[MEMORY_WRITER] = tiff_writer_memory (&tiff, width, height, bands);
+  if (work.mask_open) plan->bytes[MEMORY_MASK] = (int64_t) height * (sizeof (int64_t) + sizeof (int32_t)) +
+                        work.mask.span_count * 2 * sizeof (int32_t);
+
+  int64_t pipeline_memory = (int64_t) params->pipeline_memory * 1048576;
+  if (plan->budget) pipeline_memory = memory_share (plan, MEMORY_PIPELINE, 0, 0);
+
+  int64_t row_bytes = (int64_t) width * (sizeof (float) + 1 + bands);
+  band_rows = (int32_t) qBound ((int64_t) threads * 4, (int64_t) BAND_BYTES / row_bytes, (int64_t) 1024);
+
+
+  //  If the budget won't hold three full bands we use shorter bands rather than fewer of them.
+
+  if (plan->budget) band_rows = (int32_t) qMin ((int64_t) band_rows, qMax ((int64_t) 1, pipeline_memory / 3 / row_bytes - 1));
+
+  band_rows = qMin (band_rows, height);
+  result->threads = threads;
+  result->band_rows = band_rows;
+
+
+  //  Figure out how many bands we can have in the pipeline at once without going over the pipeline memory limit.
+  //  Three lets every stage work on a band at the same time, one more lets a fast stage get a band ahead.  We
+  //  always need at least one, in which case the stages just take turns.
+
+  int64_t band_bytes = (int64_t) (band_rows + 1) * width * sizeof (float) + (int64_t) band_rows * width * (1 + bands);
+  work.pipe_count = (int32_t) qBound ((int64_t) 1, pipeline_memory / band_bytes, (int64_t) MAX_PIPELINE_BANDS);
+  result->pipeline_bands = work.pipe_count;
+
+  plan->bytes[MEMORY_PIPELINE] = work.pipe_count * band_bytes + (int64_t) width * sizeof (float);
+
+
+  //  The fixed buffers and a single band of one row is as small as we can go.
+
+  if (plan->budget && memory_plan_total (plan) > plan->budget)
+    {
+      snprintf (result->error, sizeof (result->error),
+                "A memory budget of %d MB is too small for a %d by %d area, at least %lld MB is needed",
+                params->memory_budget, width, height, (long long) (memory_plan_total (plan) + 1048575) / 1048576);
+      convert_cleanup (&work);
+      return (CONVERT_MEMORY_ERROR);
+    }
+
+
+  //  Band buffers.  The elevation band has one extra row for the sunshade halo.
+
+  uint8_t band_failed = NVFalse;
+
+  work.halo = (float *) calloc (width, sizeof (float));
+  if (work.halo == NULL) band_failed = NVTrue;
+
+  for (i = 0 ; i < work.pipe_count ; i++)
+    {
+      work.pipe[i].rows = (float *) calloc ((int64_t) (band_rows + 1) * width, sizeof (float));
+      work.pipe[i].fill = (uint8_t *) calloc ((int64_t) band_rows * width, sizeof (uint8_t));
+      work.pipe[i].pixels = (uint8_t *) calloc ((int64_t) band_rows * width * bands, sizeof (uint8_t));
+
+      if (work.pipe[i].rows == NULL || work.pipe[i].fill == NULL || work.pipe[i].pixels == NULL) band_failed = NVTrue;
+    }
+
+
+  //  If any of the callocs failed, error out.
+
+  if (band_failed)
+    {
+      snprintf (result->error, sizeof (result->error), "Error allocating band memory : %s", strerror (errno));
+      convert_cleanup (&work);
+      return (CONVERT_ALLOCATION_ERROR);
+    }
+
+
+  //  Open the chunk aligned reader.  If it can't be opened (the elevation layer isn't where we expect it to be or
+  //  the HDF5 library won't let us open the file twice) we'll just fall back to bagReadRow.
+
+  if (params->block_reads && !work.source)
+    {
+      if (timing) stage_start (&clock);
+
+      int64_t chunk_cache = (int64_t) params->chunk_cache * 1048576, block_memory = BLOCK_BYTES;
+
+      if (plan->budget)
+        {
+          chunk_cache = memory_share (plan, MEMORY_CHUNK_CACHE, 1048576, 268435456);
+          block_memory = memory_share (plan, MEMORY_BLOCK, 0, 0);
+        }
+
+      work.reader_open = bag_reader_open (&work.reader, params->bag_file, x_start, y_start, width, height, chunk_cache,
+                                          block_memory);
+
+      if (timing) stage_stop (timing, STAGE_OPEN, &clock, 0);
+
+      if (work.reader_open)
+        {
+          result->block_reads = NVTrue;
+          result->chunk_rows = work.reader.chunk_rows;
+          result->chunk_cols = work.reader.chunk_cols;
+          result->row_chunk_reads = bag_reader_row_chunk_reads (&work.reader, 2);
+
+
+          //  The block is always at least one chunk row, even if that's more than its share.
+
+          plan->bytes[MEMORY_BLOCK] = (int64_t) work.reader.block_height * width * sizeof (float);
+          plan->bytes[MEMORY_CHUNK_CACHE] = chunk_cache;
+        }
+    }
+
+
+  //  GDAL's block cache is global so we put it back the way it was when we're done.  The COG copy goes through
+  //  it too, so this bounds tiff_writer_close as well.
+
+  if (plan->budget)
+    {
+      work.gdal_cache = GDALGetCacheMax64 ();
+      plan->bytes[MEMORY_GDAL_CACHE] = memory_share (plan, MEMORY_GDAL_CACHE, 16777216, 0);
+      GDALSetCacheMax64 (plan->bytes[MEMORY_GDAL_CACHE]);
+    }
+  else
+    {
+      plan->bytes[MEMORY_GDAL_CACHE] = GDALGetCacheMax64 ();
+    }
+
+
+  //  Figure out where the min and max values are going to come from.  The BAG min/max elevation attributes are
+  //  for the entire grid so we can't use them with an area file.  We also don't trust them if they look bogus.
+
+  int32_t minmax_source = params->minmax_source;
+
+  if (minmax_source == MINMAX_METADATA && (params->area_file[0] || !(bag_min <= bag_max) || fabsf (bag_min) >= NULL_ELEVATION ||
+                                           fabsf (bag_max) >= NULL_ELEVATION)) minmax_source = MINMAX_SPILL;
+
+
+
+  //  If the statistics sidecar has the min/max for this window (and the BAG hasn't changed since it was saved)
+  //  we don't need a min/max pass at all.  That's only for the default (spill) source, an explicit scan always
+  //  rescans.  Otherwise we'll gather the histogram on the way through the render pass and save it at the end,
+  //  as long as the min/max we render with are the real ones for the area.
+
+  BAG_STATS stats;
+  uint8_t have_stats = NVFalse;
+
+  bag_stats_init (&stats, x_start, y_start, width, height, !params->area_file[0], 0.0, 0.0);
+
+  uint8_t stats_sidecar = params->stats_sidecar && !work.source;
+
+  if (stats_sidecar && minmax_source == MINMAX_SPILL && bag_stats_load (params->bag_file, &stats))
+    {
+      have_stats = NVTrue;
+      minmax_source = MINMAX_STATS;
+    }
+
+  result->minmax_source = minmax_source;
+
+
+  //  If we're going to read the area only once, set up the row store to hold the rows for the render pass.
+
+  if (minmax_source == MINMAX_SPILL)
+    {
+      int64_t spill_memory = (int64_t) params->spill_memory * 1048576;
+      if (plan->budget) spill_memory = memory_share (plan, MEMORY_ROW_STORE, 0, 0);
+
+      if (!row_store_open (&work.store, width, height, spill_memory))
+        {
+          snprintf (result->error, sizeof (result->error), "Error opening row spill store : %s", strerror (errno));
+          convert_cleanup (&work);
+          return (CONVERT_SPILL_ERROR);
+        }
+
+      plan->bytes[MEMORY_ROW_STORE] = (int64_t) work.store.mem_rows * width * sizeof (float);
+    }
+
+
+  if (minmax_source == MINMAX_STATS)
+    {
+      min_val = stats.min_val;
+      max_val = stats.max_val;
+      result->valid_cells = stats.count;
+
+      if (params->progress && !(*params->progress) (CONVERT_MINMAX_STAGE, height, height, params->user_data))
+        {
+          strcpy (result->error, "Canceled");
+          convert_cleanup (&work);
+          return (CONVERT_CANCELED);
+        }
+    }
+  else if (minmax_source == MINMAX_METADATA)
+    {
+      //  Elevations in the BAG are positive up and we're coloring by depth.
+
+      min_val = -bag_max;
+      max_val = -bag_min;
+
+      if (params->progress && !(*params->progress) (CONVERT_MINMAX_STAGE, height, height, params->user_data))
+        {
+          strcpy (result->error, "Canceled");
+          convert_cleanup (&work);
+          return (CONVERT_CANCELED);
+        }
+    }
+  else
+    {
+      float *current_row = work.halo;
+
+      if (timing) stage_start (&clock);
+
+      min_val = 999999999.0;
+      max_val = -999999999.0;
+
+      for (i = 0 ; i < height ; i++)
+        {
+          if (!read_bag_row (&work, i, x_start, y_start, width, current_row))
+            {
+              snprintf (result->error, sizeof (result->error), "Error reading row %d of %s", y_start + i, params->bag_file);
+              convert_cleanup (&work);
+              return (CONVERT_READ_ERROR);
+            }
+
+          for (j = 0 ; j < width ; j++)
+            {
+              if (current_row[j] != NULL_ELEVATION)
+                {
+                  float val = -current_row[j];
+                  if (min_val > val) min_val = val;
+                  if (max_val < val) max_val = val;
+                }
+            }
+
+
+          if (work.store.height && !row_store_put (&work.store, i, current_row))
+            {
+              snprintf (result->error, sizeof (result->error), "Error writing row spill store : %s", strerror (errno));
+              convert_cleanup (&work);
+              return (CONVERT_SPILL_ERROR);
+            }
+
+          if (params->progress && !(*params->progress) (CONVERT_MINMAX_STAGE, i + 1, height, params->user_data))
+            {
+              strcpy (result->error, "Canceled");
+              convert_cleanup (&work);
+              return (CONVERT_CANCELED);
+            }
+        }
+
+      if (timing)
+        {
+          stage_stop (timing, STAGE_MINMAX, &clock, (int64_t) width * height);
+          timing->bytes_read += (int64_t) width * height * sizeof (float);
+        }
+    }
+
+  result->min_val = min_val;
+  result->max_val = max_val;
+  result->spill_bytes = work.store.spill_bytes;
+
+
+  rp.min_val = min_val;
+  rp.range[0] = rp.range[1] = 0.0;
+
+  if (params->restart && min_val < 0.0)
+    {
+      rp.range[0] = -min_val;
+      rp.range[1] = max_val;
+
+      rp.cross_zero = NVTrue;
+    }
+  else
+    {
+      rp.range[0] = max_val - min_val;
+
+      rp.cross_zero = NVFalse;
+    }
+
+
+
+  //  Set up the output GeoTIFF file.
+
+  double trans[6];
+
+  trans[0] = mbr.min_x;
+  trans[1] = x_bin_size_degrees;
+  trans[2] = 0.0;
+  trans[3] = mbr.max_y;
+  trans[4] = 0.0;
+  trans[5] = -y_bin_size_degrees;
+
+  if (!tiff_writer_open (&work.writer, name, width, height, bands, trans, &tiff))
+    {
+      snprintf (result->error, sizeof (result->error), "Could not create %s", name);
+      convert_cleanup (&work);
+      return (CONVERT_CREATE_ERROR);
+    }
+
+
+  if (threads > 1)
+    {
+      work.pool = new QThreadPool;
+      work.pool->setMaxThreadCount (threads);
+    }
+
+
+  //  Render the output in bands from the top (north) down.  Reading the BAG (or the row store) and writing the
+  //  GeoTIFF each run in their own thread so that GDAL compressing band N overlaps reading and rendering band N + 1.
+  //  Rendering stays in this thread (using the pool) so the progress callback is always called from the caller's
+  //  thread.
+
+  CONVERT_PIPELINE cp;
+
+  cp.work = &work;
+  cp.x_start = x_start;
+  cp.y_start = y_start;
+  cp.width = width;
+  cp.height = height;
+  cp.band_rows = band_rows;
+  cp.read_error_row = -1;
+  cp.stats = NULL;
+  cp.timing = timing;
+
+  if (stats_sidecar && !have_stats && minmax_source != MINMAX_METADATA)
+    {
+      bag_stats_init (&stats, x_start, y_start, width, height, !params->area_file[0], min_val, max_val);
+      cp.stats = &stats;
+    }
+
+  for (i = 0 ; i < work.pipe_count ; i++) cp.empty.put (i);
+
+
+  stageThread reader (reader_stage, &cp), writer (writer_stage, &cp);
+
+  reader.start ();
+  writer.start ();
+
+
+  int32_t b;
+  uint8_t canceled = NVFalse;
+
+  while ((b = cp.loaded.get ()) >= 0)
+    {
+      PIPELINE_BAND *band = &work.pipe[b];
+
+
+      //  Once we've been canceled the reader gets no more bands and we just drop the ones already read.
+
+      if (canceled) continue;
+
+      render_band (&rp, band->rows, band->num_rows, band->fill, band->pixels, work.pool);
+
+      cp.rendered.put (b);
+
+
+      if (params->progress &&
+          !(*params->progress) (CONVERT_RENDER_STAGE, band->first_row + band->num_rows, height, params->user_data))
+        {
+          canceled = NVTrue;
+          cp.empty.abort ();
+        }
+    }
+
+  cp.rendered.close ();
+
+  reader.wait ();
+  writer.wait ();
+
+
+  //  Get rid of the partial GeoTIFF if we were canceled or couldn't read the BAG.
+
+  if (canceled)
+    {
+      discard_output (&work, name);
+
+      strcpy (result->error, "Canceled");
+      convert_cleanup (&work);
+      return (CONVERT_CANCELED);
+    }
+
+
+  if (cp.read_error_row >= 0)
+    {
+      discard_output (&work, name);
+
+      snprintf (result->error, sizeof (result->error), "Error reading row %d of %s", y_start + cp.read_error_row,
+                params->bag_file);
+      convert_cleanup (&work);
+      return (CONVERT_READ_ERROR);
+    }
+
+
+  if (work.reader_open) result->chunk_reads = work.reader.chunk_reads;
+
+
+  //  Every row of the area has been through the reader so the histogram is complete.  Not being able to save it
+  //  (say the BAG is on a read only or shared disk) isn't an error, we'll just have to do the min/max pass again
+  //  next time.
+
+  if (cp.stats)
+    {
+      result->valid_cells = stats.count;
+      bag_stats_save (params->bag_file, &stats);
+    }
+
+
+  //  Close the output file here so that we know if flushing the last of it worked.
+
+  if (timing) stage_start (&clock);
+
+  tiff_writer_close (&work.writer);
+
+  plan->peak_rss = peak_rss_kb ();
+
+  if (timing)
+    {
+      stage_stop (timing, STAGE_CLOSE, &clock, 0);
+
+      timing->memory = *plan;
+
+      timing->output_bytes = QFileInfo (name).size ();
+      timing->shade_in_color = !rp.fast_shade && !rp.shade_lut;
+      stage_times_stop (timing, &run_clock);
+    }
+
+  if (rp.shade_lut)
+    {
+      result->lut_checked = rp.shade_lut->checked;
+      result->lut_mismatches = rp.shade_lut->mismatches;
+
+      if (timing)
+        {
+          timing->lut_checked = result->lut_checked;
+          timing->lut_mismatches = result->lut_mismatches;
+        }
+    }
+
+  result->write_errors = work.writer.write_errors;
+  result->failed_row = work.writer.failed_row;
+  result->write_time = work.writer.write_time;
+
+
+  convert_cleanup (&work);
+
+
+  return (CONVERT_SUCCESS);
+}
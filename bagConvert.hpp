@@ -0,0 +1,210 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef BAGCONVERT_H
+#define BAGCONVERT_H
+
+#include "bagGeotiffDef.hpp"
+#include "rowStore.hpp"
+#include "render.hpp"
+#include "bagReader.hpp"
+#include "tiffWriter.hpp"
+#include "pipeline.hpp"
+#include "bagStats.hpp"
+#include "areaMask.hpp"
+#include "stageTimer.hpp"
+#include "memoryPlan.hpp"
+#include "paletteCache.hpp"
+
+
+/*!
+    The conversion engine.  This is everything that used to live in bagGeotiff::slotCustomButtonClicked with
+    all of the Qt widget code pulled out so that it can be run from the wizard, from the command line (see
+    batch.cpp), or from anything else that can fill in a CONVERT_PARAMS structure.  Nothing in here may touch
+    a widget or call qApp->processEvents.  Progress is reported through the optional callback.
+*/
+
+
+//  Stages passed to the progress callback.
+
+#define         CONVERT_MINMAX_STAGE        0
+#define         CONVERT_RENDER_STAGE        1
+
+
+//  Where the min and max values for the color map come from.
+//
+//  - MINMAX_SPILL     -  Read the area once, keeping the rows in a ROW_STORE (rowStore.cpp) for the render pass.
+//  - MINMAX_METADATA  -  Use the min/max elevation attributes from the BAG.  Only used when there is no area file,
+//                        otherwise we fall back to MINMAX_SPILL.
+//  - MINMAX_SCAN      -  The old way.  Read every row twice.
+//  - MINMAX_STATS     -  Only ever set in CONVERT_RESULT.  The min/max came from the BAG's statistics sidecar
+//                        (bagStats.hpp) so the area was only read once, without a row store.
+
+#define         MINMAX_SPILL                0
+#define         MINMAX_METADATA             1
+#define         MINMAX_SCAN                 2
+#define         MINMAX_STATS                3
+
+
+//  Rough size of the render band buffers.  The band height is computed from this and the output width.
+
+#define         BAND_BYTES                  67108864
+
+
+//  Rough size of the chunk aligned block buffer used by the BAG_READER (bagReader.cpp).
+
+#define         BLOCK_BYTES                 33554432
+
+
+//  Return values from bag_convert.
+
+#define         CONVERT_SUCCESS             0
+#define         CONVERT_BAG_OPEN_ERROR      -1
+#define         CONVERT_AREA_FILE_ERROR     -2
+#define         CONVERT_AREA_BOUNDS_ERROR   -3
+#define         CONVERT_ALLOCATION_ERROR    -4
+#define         CONVERT_CREATE_ERROR        -5
+#define         CONVERT_SPILL_ERROR         -6
+#define         CONVERT_READ_ERROR          -7
+#define         CONVERT_CANCELED            -8
+#define         CONVERT_MEMORY_ERROR        -9
+
+
+//  Progress callback.  Return NVFalse to cancel the conversion (the way a GDALProgressFunc does).  bag_convert
+//  then stops at the next row (min/max pass) or band (render pass), closes everything, and removes the partial
+//  output file.
+
+typedef uint8_t (*CONVERT_PROGRESS) (int32_t stage, int32_t value, int32_t max, void *user_data);
+
+
+//  Elevation source other than a BAG file (the synthetic grids in synthGrid.cpp, for instance).  read_row fills
+//  data with width elevations (positive up, NULL_ELEVATION for empty cells) of grid row row (0 is the southern row)
+//  starting at column col, and returns NVFalse if it can't.  The grid is described the way the BAG definition
+//  describes it.
+
+typedef uint8_t (*CONVERT_ROW_READER) (int32_t row, int32_t col, int32_t width, float *data, void *user_data);
+
+typedef struct
+{
+  int32_t       cols;
+  int32_t       rows;
+  double        x_spacing;                  //  Degrees
+  double        y_spacing;
+  double        sw_x;                       //  Southwest corner
+  double        sw_y;
+  float         min_elevation;              //  Same as the BAG min/max elevation attributes
+  float         max_elevation;
+  CONVERT_ROW_READER read_row;
+  void          *user_data;
+} CONVERT_SOURCE;
+
+
+typedef struct
+{
+  char          bag_file[1024];
+  char          output_file[1024];
+  char          area_file[1024];            //  Empty string means no area file
+  uint8_t       transparent;
+  uint8_t       caris;                      //  Overrides tiff.mode with TIFF_CARIS
+  uint8_t       restart;
+  double        azimuth;
+  double        elevation;
+  double        exaggeration;
+  double        saturation;
+  double        value;
+  double        start_hsv;
+  double        end_hsv;
+  int32_t       minmax_source;              //  MINMAX_SPILL, MINMAX_METADATA, or MINMAX_SCAN
+  uint8_t       stats_sidecar;              //  Use (and save) the BAG_FILE.stats min/max and histogram (bagStats.hpp)
+  int32_t       spill_memory;               //  Megabytes of rows to keep in memory before spilling to disk
+  int32_t       threads;                    //  Number of render threads, 0 for one per core
+  uint8_t       block_reads;                //  Read chunk aligned blocks with a BAG_READER instead of bagReadRow
+  int32_t       chunk_cache;                //  HDF5 chunk cache size in megabytes for the BAG_READER, 0 for the default
+  int32_t       pipeline_memory;            //  Megabytes of bands allowed in flight in the read/render/write pipeline
+  int32_t       memory_budget;              //  Megabytes for all of the buffers (memoryPlan.hpp), 0 to use the limits above
+  uint8_t       fast_shade;                 //  Use the row hillshade kernel (shade.cpp) if it passes shade_row_check.
+                                            //  Off by default, it can be a shade level off from sunshade now and then
+  uint8_t       lut_shade;                  //  Look the shade factors up in a SHADE_LUT (shade.hpp) instead
+  TIFF_OPTIONS  tiff;                       //  Output format options (tiffWriter.hpp)
+  STAGE_TIMES   *timing;                    //  Stage instrumentation (stageTimer.hpp), NULL (the default) for none
+  CONVERT_SOURCE *source;                   //  Read from this instead of bag_file if not NULL (no block reads or sidecar)
+  CONVERT_PROGRESS progress;                //  Optional, may be NULL
+  void          *user_data;                 //  Passed back to the progress callback
+} CONVERT_PARAMS;
+
+
+typedef struct
+{
+  int32_t       width;
+  int32_t       height;
+  int32_t       write_errors;               //  Number of failed TIFF scanline writes
+  int32_t       failed_row;                 //  Last output row that failed to write, -1 if the COG copy failed
+  double        write_time;                 //  Seconds spent writing the GeoTIFF (including building overviews)
+  int32_t       threads;                    //  Number of render threads actually used
+  int32_t       band_rows;                  //  Height of the render bands
+  int32_t       pipeline_bands;             //  Number of bands in the pipeline
+  uint8_t       block_reads;                //  NVTrue if the BAG_READER was used
+  int32_t       chunk_rows;                 //  HDF5 chunk dimensions of the elevation layer
+  int32_t       chunk_cols;
+  int64_t       chunk_reads;                //  Chunk decompressions done by the BAG_READER
+  int64_t       row_chunk_reads;            //  Estimated chunk decompressions of the old two pass bagReadRow method
+  uint8_t       fast_shade;                 //  NVTrue if the row hillshade kernel was used
+  int32_t       shade_level;                //  SHADE_SCALAR, SHADE_SSE, or SHADE_AVX2
+  float         shade_diff;                 //  Largest difference between shade_row and sunshade in the check
+  uint8_t       lut_shade;                  //  NVTrue if the shade lookup table was used
+  int64_t       lut_checked;                //  Cells whose table shade level was compared with sunshade
+  int64_t       lut_mismatches;             //  Compared cells where the table picked a different shade level
+  float         min_val;
+  float         max_val;
+  int32_t       minmax_source;              //  The min/max source that was actually used
+  int64_t       valid_cells;                //  Non-null cells in the area (0 if the statistics weren't gathered)
+  uint8_t       area_mask;                  //  NVTrue if cells outside the area polygon were masked out
+  int64_t       spill_bytes;                //  Bytes written to the row store spill file
+  MEMORY_PLAN   memory;                     //  What each buffer was given and the peak RSS (memoryPlan.hpp)
+  char          output_file[1024];          //  Actual output file name (.tif appended if needed)
+  char          error[2048];                //  Error message if bag_convert returns other than CONVERT_SUCCESS
+} CONVERT_RESULT;
+
+
+void set_convert_defaults (CONVERT_PARAMS *params);
+void set_convert_sunopts (CONVERT_PARAMS *params, SUN_OPT *sunopts);
+int32_t bag_convert (CONVERT_PARAMS *params, CONVERT_RESULT *result);
+int32_t batch_main (int32_t argc, char **argv);
+
+
+#endif
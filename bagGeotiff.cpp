@@ -62,26 +62,15 @@ bagGeotiff::bagGeotiff (int32_t *argc, char **argv, QWidget *parent)
   //  Get the sample data for the color and sunshade examples.
 
   options.sample_pixmap = QPixmap (SAMPLE_WIDTH, SAMPLE_HEIGHT);
-  uint8_t idata[2];
-  QFile *dataFile = new QFile (":/icons/data.dat");
   options.sample_min = 99999.0;
   options.sample_max = -99999.0;
 
-  if (dataFile->open (QIODevice::ReadOnly))
-    {
-      for (int32_t i = 0 ; i < SAMPLE_HEIGHT ; i++)
-        {
-          for (int32_t j = 0 ; j < SAMPLE_WIDTH ; j++)
-            {
-              dataFile->read ((char *) idata, 2);
-              options.sample_data[i][j] = idata[1] * 256 + idata[0];
-
-              options.sample_min = qMin ((float) options.sample_data[i][j], options.sample_min);
-              options.sample_max = qMax ((float) options.sample_data[i][j], options.sample_max);
-            }
-        }
-      dataFile->close ();
-    }
+  sample_grid_read (options.sample_data, &options.sample_min, &options.sample_max);
+
+
+  //  Build the sample preset palettes now so switching presets on the image page is free.
+
+  palette_cache_init ();
 
 
   //  Get the user's defaults if available
@@ -106,6 +95,13 @@ bagGeotiff::bagGeotiff (int32_t *argc, char **argv, QWidget *parent)
   area_file_name = tr ("NONE");
 
 
+  //  The conversion runs in this thread so that the GUI stays alive and can cancel it.
+
+  worker = new convertThread (this);
+  connect (worker, SIGNAL (progress (int, int, int)), this, SLOT (slotConvertProgress (int, int, int)));
+  connect (worker, SIGNAL (finished ()), this, SLOT (slotConvertDone ()));
+
+
   //  Set the window size and location from the defaults
 
   this->resize (options.window_width, options.window_height);
@@ -132,6 +128,13 @@ bagGeotiff::bagGeotiff (int32_t *argc, char **argv, QWidget *parent)
 
 bagGeotiff::~bagGeotiff ()
 {
+  //  Don't let the worker get deleted out from under a running conversion.
+
+  if (worker->isRunning ())
+    {
+      worker->cancel ();
+      worker->wait ();
+    }
 }
 
 
@@ -303,390 +306,155 @@ void bagGeotiff::cleanupPage (int id)
 
 
 
-void bagGeotiff::slotHelpClicked ()
-{
-  QWhatsThis::enterWhatsThisMode ();
-}
-
-
-
-//  This is where the fun stuff happens.
+//  Cancel (or closing the window) while a conversion is running asks the worker to stop instead of leaving.  We
+//  find out that it has stopped in slotConvertDone.
 
-void 
-bagGeotiff::slotCustomButtonClicked (int id __attribute__ ((unused)))
+void bagGeotiff::reject ()
 {
-  int32_t             i, j, k, m, c_index, width, height, x_start, y_start, count = 0;
-  float               *current_row, *next_row, min_val, max_val, range[2] = {0.0, 0.0}, shade_factor;
-  double              conversion_factor, mid_y_radians, x_cell_size, y_cell_size, x_bin_size_degrees,
-                      y_bin_size_degrees;
-  double              polygon_x[200], polygon_y[200];
-  NV_F64_XYMBR        bag_mbr, mbr;
-  uint8_t             *fill, cross_zero = NVFalse;
-  char                bag_file[512], name[512], area_file[512];
-  QString             string;
-  bagError            bagErr;
-  bagHandle           bag_handle;
-
-
-  QApplication::setOverrideCursor (Qt::WaitCursor);
-
-
-  button (QWizard::FinishButton)->setEnabled (false);
-  button (QWizard::BackButton)->setEnabled (false);
-  button (QWizard::CustomButton1)->setEnabled (false);
-
-
-  //  Note - The sunopts and the color_array get set in display_sample_data (imagePage.cpp).  No point in
-  //  doing it twice.
-
-
-  strcpy (bag_file, bag_file_name.toLatin1 ());
-
-
-  //  Open the BAG file.
-
-  if ((bagErr = bagFileOpen (&bag_handle, BAG_OPEN_READONLY, (u8 *) bag_file)) != BAG_SUCCESS)
-    {
-      u8 *errstr;
-
-      if (bagGetErrorString (bagErr, &errstr) == BAG_SUCCESS)
-        {
-          string.sprintf (tr ("Error opening BAG file : %s").toLatin1 (), errstr);
-          QMessageBox::warning (0, tr ("bagGeotiff"), string);
-        }
-
-      exit (-1);
-    }
-
-  int32_t data_cols = bagGetDataPointer (bag_handle)->def.ncols;
-  int32_t data_rows = bagGetDataPointer (bag_handle)->def.nrows;
-  x_bin_size_degrees = bagGetDataPointer (bag_handle)->def.nodeSpacingX;
-  y_bin_size_degrees = bagGetDataPointer (bag_handle)->def.nodeSpacingY;
-  bag_mbr.min_x = bagGetDataPointer (bag_handle)->def.swCornerX;
-  bag_mbr.min_y = bagGetDataPointer (bag_handle)->def.swCornerY;
-  bag_mbr.max_x = bag_mbr.min_x + data_cols * x_bin_size_degrees;
-  bag_mbr.max_y = bag_mbr.min_y + data_rows * y_bin_size_degrees;
-
-  //fprintf(stderr,"%s %s %d %d %d %f %f %f %f %f %f\n",__FILE__,__FUNCTION__,__LINE__,data_cols,data_rows,x_bin_size_degrees,y_bin_size_degrees,bag_mbr.min_x,bag_mbr.min_y,bag_mbr.max_x,bag_mbr.max_y);
-
-  strcpy (name, output_file_name.toLatin1 ());
-
-  if (strcmp (&name[strlen (name) - 4], ".tif")) strcat (name, ".tif");
-
-
-  x_start = 0;
-  y_start = 0;
-  width = data_cols;
-  height = data_rows;
-
-
-  //  Check for an area file.
-
-  mbr = bag_mbr;
-  if (!area_file_name.isEmpty ())
+  if (worker->isRunning ())
     {
-      strcpy (area_file, area_file_name.toLatin1 ());
-
-      if (!get_area_mbr (area_file, &count, polygon_x, polygon_y, &mbr))
-        {
-          QString qstring = QString (tr ("Error reading area file %1\nReason : %2")).arg (area_file_name).arg (QString (strerror (errno)));
-          QMessageBox::critical (this, tr ("bagGeotiff"), qstring);
-          exit (-1);
-        }
+      worker->cancel ();
 
+      button (QWizard::CancelButton)->setEnabled (false);
 
-      if (mbr.min_y > bag_mbr.max_y || mbr.max_y < bag_mbr.min_y || mbr.min_x > bag_mbr.max_x || mbr.max_x < bag_mbr.min_x)
-        {
-          QString qstring = QString (tr ("Specified area is completely outside of the BAG bounds!"));
-          QMessageBox::critical (this, tr ("bagGeotiff"), qstring);
-          exit (-1);
-        }
+      QListWidgetItem *cur = new QListWidgetItem (tr ("Canceling..."));
+      checkList->addItem (cur);
+      checkList->scrollToItem (cur);
 
+      return;
+    }
 
-      //  Match to nearest cell
+  QWizard::reject ();
+}
 
-      x_start = NINT ((mbr.min_x - bag_mbr.min_x) / x_bin_size_degrees);
-      y_start = NINT ((mbr.min_y - bag_mbr.min_y) / y_bin_size_degrees);
-      width = NINT ((mbr.max_x - mbr.min_x) / x_bin_size_degrees);
-      height = NINT ((mbr.max_y - mbr.min_y) / y_bin_size_degrees);
 
 
-      //  Adjust to BAG bounds if necessary
+void bagGeotiff::slotHelpClicked ()
+{
+  QWhatsThis::enterWhatsThisMode ();
+}
 
-      if (x_start < 0) x_start = 0;
-      if (y_start < 0) y_start = 0;
-      if (x_start + width > data_cols) width = data_cols - x_start;
-      if (y_start + height > data_rows) height = data_rows - y_start;
 
 
-      //  Redefine bounds
+//  Progress from the conversion thread (already throttled by convertThread).
 
-      mbr.min_x = bag_mbr.min_x + x_start * x_bin_size_degrees;
-      mbr.min_y = bag_mbr.min_y + y_start * y_bin_size_degrees;
-      mbr.max_x = mbr.min_x + width * x_bin_size_degrees;
-      mbr.max_y = mbr.min_y + height * y_bin_size_degrees;
-    }
+void bagGeotiff::slotConvertProgress (int stage, int value, int max)
+{
+  QProgressBar *bar = progress.gbar;
 
-  progress.mbar->setRange (0, height);
+  if (stage == CONVERT_MINMAX_STAGE) bar = progress.mbar;
 
+  if (bar->maximum () != max) bar->setRange (0, max);
 
-  //  Compute cell sizes for sunshading.
+  bar->setValue (value);
+}
 
-  mid_y_radians = (bag_mbr.max_y - bag_mbr.min_y) * 0.0174532925199432957692;
-  conversion_factor = cos (mid_y_radians);
-  x_cell_size = x_bin_size_degrees * 111120.0 * conversion_factor;
-  y_cell_size = y_bin_size_degrees * 111120.0;
 
 
-  uint8_t *red = (uint8_t *) calloc (width, sizeof (uint8_t));
-  uint8_t *green = (uint8_t *) calloc (width, sizeof (uint8_t));
-  uint8_t *blue = (uint8_t *) calloc (width, sizeof (uint8_t));
-  uint8_t *alpha = (uint8_t *) calloc (width, sizeof (uint8_t));
+//  The actual conversion is done in bag_convert (bagConvert.cpp) so that it can also be run from the command line.
+//  Here we just start it in the convertThread.  slotConvertDone picks up the results.
 
+void 
+bagGeotiff::slotCustomButtonClicked (int id __attribute__ ((unused)))
+{
+  CONVERT_PARAMS      params;
 
-  next_row = (float *) calloc (width, sizeof (float));
-  current_row = (float *) calloc (width, sizeof (float));
 
+  QApplication::setOverrideCursor (Qt::WaitCursor);
 
-  //  If the calloc failed, error out.
-    
-  if (current_row == NULL)
-    {
-      perror (__FILE__);
-      exit (-1);
-    }
 
+  button (QWizard::FinishButton)->setEnabled (false);
+  button (QWizard::BackButton)->setEnabled (false);
+  button (QWizard::CustomButton1)->setEnabled (false);
+  button (QWizard::CancelButton)->setEnabled (true);
 
 
-  min_val = 999999999.0;
-  max_val = -999999999.0;
+  set_convert_defaults (&params);
 
-  for (i = 0, m = 1 ; i < height ; i++, m++)
-    {
-      bagErr = bagReadRow (bag_handle, y_start + i, x_start, width - 1, Elevation, (void *) current_row);
+  strcpy (params.bag_file, bag_file_name.toLatin1 ());
+  strcpy (params.output_file, output_file_name.toLatin1 ());
+  if (!area_file_name.isEmpty ()) strcpy (params.area_file, area_file_name.toLatin1 ());
 
-      for (j = 0 ; j < width ; j++)
-        {
-          if (current_row[j] != NULL_ELEVATION)
-            {
-              float val = -current_row[j];
-              if (min_val > val) min_val = val;
-              if (max_val < val) max_val = val;
-            }
-        }
+  params.transparent = options.transparent;
+  params.caris = options.caris;
+  params.restart = options.restart;
+  params.azimuth = options.azimuth;
+  params.elevation = options.elevation;
+  params.exaggeration = options.exaggeration;
+  params.saturation = options.saturation;
+  params.value = options.value;
+  params.start_hsv = options.start_hsv;
+  params.end_hsv = options.end_hsv;
 
-      progress.mbar->setValue (m);
 
-      qApp->processEvents ();
-    }
+  worker->convert (&params);
+}
 
 
-  progress.mbar->setValue (height);
 
+void bagGeotiff::slotConvertDone ()
+{
+  CONVERT_RESULT      *result = &worker->result;
+  QString             string;
 
 
-  progress.gbar->setRange (0, height);
+  QApplication::restoreOverrideCursor ();
 
 
-  if (options.restart && min_val < 0.0)
-    {
-      range[0] = -min_val;
-      range[1] = max_val;
+  //  If we were canceled bag_convert has already closed everything and removed the partial file so we can let
+  //  them change things and try again.
 
-      cross_zero = NVTrue;
-    }
-  else
+  if (worker->status == CONVERT_CANCELED)
     {
-      range[0] = max_val - min_val;
+      progress.mbar->setValue (0);
+      progress.gbar->setValue (0);
 
-      cross_zero = NVFalse;
-    }
+      QListWidgetItem *cur = new QListWidgetItem (tr ("Conversion canceled, the partial GeoTIFF was removed."));
+      checkList->addItem (cur);
+      checkList->setCurrentItem (cur);
+      checkList->scrollToItem (cur);
 
+      button (QWizard::BackButton)->setEnabled (true);
+      button (QWizard::CustomButton1)->setEnabled (true);
+      button (QWizard::CancelButton)->setEnabled (true);
 
-  fill = (uint8_t *) calloc (width, sizeof (uint8_t));
-  if (fill == NULL)
-    {
-      perror (tr ("Allocating fill").toLatin1 ());
-      exit (-1);
+      return;
     }
 
 
-
-  OGRSpatialReference ref;
-  GDALDataset         *df;
-  char                *wkt = NULL;
-  GDALRasterBand      *bd[4];
-  double              trans[6];
-  GDALDriver          *gt;
-  char                **papszOptions = NULL;
-
-
-  //  Set up the output GeoTIFF file.
-
-  GDALAllRegister ();
-
-  gt = GetGDALDriverManager ()->GetDriverByName ("GTiff");
-  if (!gt)
+  if (worker->status != CONVERT_SUCCESS)
     {
-      QMessageBox::critical (0, tr ("bagGeotiff"), tr ("Could not get GTiff driver!"));
+      QMessageBox::critical (this, tr ("bagGeotiff"), QString (result->error));
       exit (-1);
     }
 
-  int32_t bands = 3;
-  if (options.transparent) bands = 4;
-
-
-  //  Stupid Caris software can't read normal files!
 
-  if (options.caris)
-    {
-      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "PACKBITS");
-    }
-  else
-    {
-      papszOptions = CSLSetNameValue (papszOptions, "TILED", "NO");
-      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "LZW");
-    }
+  progress.mbar->setValue (result->height);
 
-  df = gt->Create (name, width, height, bands, GDT_Byte, papszOptions);
-  if (df == NULL)
-    {
-      string.sprintf (tr ("Could not create %s").toLatin1 (), name);
-      QMessageBox::critical (0, tr ("bagGeotiff"), string);
-      exit (-1);
-    }
 
-  trans[0] = mbr.min_x;
-  trans[1] = x_bin_size_degrees;
-  trans[2] = 0.0;
-  trans[3] = mbr.max_y;
-  trans[4] = 0.0;
-  trans[5] = -y_bin_size_degrees;
-  df->SetGeoTransform (trans);
-  ref.SetWellKnownGeogCS ("EPSG:4326");
-  ref.exportToWkt (&wkt);
-  df->SetProjection (wkt);
-  CPLFree (wkt);
-  for (i = 0 ; i < bands ; i++) bd[i] = df->GetRasterBand (i + 1);
-
-
-  for (i = height - 1, k = 0 ; i >= 0 ; i--, k++)
+  if (result->write_errors)
     {
-      if (i == (height - 1))
-        {
-          bagErr = bagReadRow (bag_handle, y_start + i, x_start, width - 1, Elevation, (void *) current_row);
-
-          for (j = 0 ; j < width ; j++) current_row[j] = -current_row[j];
-
-          memcpy (next_row, current_row, width * sizeof (float));
-        }
-      else
-        {
-          memcpy (current_row, next_row, width * sizeof (float));
-
-          bagErr = bagReadRow (bag_handle, y_start + i, x_start, width - 1, Elevation, (void *) next_row);
-
-          for (j = 0 ; j < width ; j++) next_row[j] = -next_row[j];
-        }
-
-
-      memset (fill, 1, width);
-
-
-      for (j = 0 ; j < width ; j++)
-        {
-          if (current_row[j] != -NULL_ELEVATION)
-            {
-              float val = current_row[j];
-
-              if (cross_zero)
-                {
-                  if (val < 0.0)
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((val - min_val) / range[0] * NUMHUES))) * NUMSHADES;
-                    }
-                  else
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf (val) / range[1] * NUMHUES)) * NUMSHADES;
-                    }
-                }
-              else
-                {
-                  c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((val - min_val) / range[0] * NUMHUES))) * NUMSHADES;
-                }
-            }
-          else
-            {
-              c_index = -2; 
-            }
-
-          shade_factor = sunshade (next_row, current_row, j, &options.sunopts, x_cell_size, y_cell_size);
-
-          if (shade_factor < 0.0) shade_factor = options.sunopts.min_shade;
-
-          c_index -= NINT (NUMSHADES * shade_factor + 0.5);
-
-
-          if (fill[j] && c_index >= 0)
-            {
-              red[j] = options.color_array[c_index].red ();
-              green[j] = options.color_array[c_index].green ();
-              blue[j] = options.color_array[c_index].blue ();
-              alpha[j] = 255;
-            }
-          else
-            {
-              red[j] = green[j] = blue[j] = alpha[j] = 0;
-            }
-        }
-
-      CPLErr err = bd[0]->RasterIO (GF_Write, 0, k, width, 1, red, width, 1, GDT_Byte, 0, 0);
-      err = bd[1]->RasterIO (GF_Write, 0, k, width, 1, green, width, 1, GDT_Byte, 0, 0);
-      err = bd[2]->RasterIO (GF_Write, 0, k, width, 1, blue, width, 1, GDT_Byte, 0, 0);
-      if (options.transparent) err = bd[3]->RasterIO (GF_Write, 0, k, width, 1, alpha, width, 1, GDT_Byte, 0, 0);
-
-      if (err == CE_Failure)
-        {
-          checkList->clear ();
-
-          string = QString (tr ("Failed a TIFF scanline write - row %1")).arg (i);
-          checkList->addItem (string);
-        }
-
-
-      progress.gbar->setValue (k + 1);
+      checkList->clear ();
 
-      qApp->processEvents ();
+      string = QString (tr ("Failed a TIFF scanline write - row %1")).arg (result->failed_row);
+      checkList->addItem (string);
     }
 
 
   checkList->addItem (" ");
   checkList->addItem (" ");
 
-  string = QString (tr ("Created TIFF file %1")).arg (name);
+  string = QString (tr ("Created TIFF file %1")).arg (result->output_file);
   checkList->addItem (string);
 
-  string = QString (tr ("%1 rows by %2 columns")).arg (height).arg (width);
+  string = QString (tr ("%1 rows by %2 columns")).arg (result->height).arg (result->width);
   checkList->addItem (string);
 
 
-  delete df;
-
-
-  free (fill);
-
-
-  bagFileClose (bag_handle);
-
-
   button (QWizard::FinishButton)->setEnabled (true);
   button (QWizard::CancelButton)->setEnabled (false);
 
 
-  QApplication::restoreOverrideCursor ();
-  qApp->processEvents ();
-
-
   checkList->addItem (" ");
   QListWidgetItem *cur = new QListWidgetItem (tr ("Conversion complete, press Finish to exit."));
 
@@ -40,6 +40,9 @@
 #define BAGGEOTIFF_H
 
 #include "bagGeotiffDef.hpp"
+#include "bagConvert.hpp"
+#include "convertThread.hpp"
+#include "synthGrid.hpp"
 #include "startPage.hpp"
 #include "imagePage.hpp"
 #include "runPage.hpp"
@@ -60,6 +63,7 @@ protected:
 
   void initializePage (int id);
   void cleanupPage (int id);
+  void reject ();
 
   void envin (OPTIONS *options);
   void envout (OPTIONS *options);
@@ -74,11 +78,15 @@ protected:
 
   QString          bag_file_name, output_file_name, area_file_name;
 
+  convertThread    *worker;
+
 
 protected slots:
 
   void slotHelpClicked ();
   void slotCustomButtonClicked (int id);
+  void slotConvertProgress (int stage, int value, int max);
+  void slotConvertDone ();
 
 };
 
@@ -17,20 +17,63 @@ DEPENDPATH += .
 INCLUDEPATH += .
 
 # Input
-HEADERS += bagGeotiff.hpp \
+HEADERS += areaMask.hpp \
+           bagConvert.hpp \
+           bagGeotiff.hpp \
            bagGeotiffDef.hpp \
            bagGeotiffHelp.hpp \
+           bagPyramid.hpp \
+           bagReader.hpp \
+           bagStats.hpp \
+           bench.hpp \
+           buildCache.hpp \
+           convertThread.hpp \
+           golden.hpp \
            imagePage.hpp \
            imagePageHelp.hpp \
+           jobScheduler.hpp \
+           memoryPlan.hpp \
+           paletteCache.hpp \
+           pipeline.hpp \
+           previewThread.hpp \
+           render.hpp \
+           renderThread.hpp \
+           rowStore.hpp \
            runPage.hpp \
+           shade.hpp \
+           stageTimer.hpp \
            startPage.hpp \
            startPageHelp.hpp \
+           synthGrid.hpp \
+           tiffWriter.hpp \
            version.hpp
-SOURCES += bagGeotiff.cpp \
+SOURCES += areaMask.cpp \
+           bagConvert.cpp \
+           bagGeotiff.cpp \
+           bagPyramid.cpp \
+           bagReader.cpp \
+           bagStats.cpp \
+           batch.cpp \
+           bench.cpp \
+           buildCache.cpp \
+           convertThread.cpp \
+           golden.cpp \
            hsvrgb.cpp \
            imagePage.cpp \
+           jobScheduler.cpp \
            main.cpp \
+           memoryPlan.cpp \
+           paletteCache.cpp \
            palshd.cpp \
+           pipeline.cpp \
+           previewThread.cpp \
+           render.cpp \
+           renderThread.cpp \
+           rowStore.cpp \
            runPage.cpp \
-           startPage.cpp
+           shade.cpp \
+           stageTimer.cpp \
+           startPage.cpp \
+           synthGrid.cpp \
+           tiffWriter.cpp
 RESOURCES += icons.qrc
@@ -67,6 +67,19 @@
 #define         SAMPLE_WIDTH        130
 
 
+//  Saturation, value, start hue, and end hue of the sample color presets on the image page.  The golden image
+//  checks (golden.cpp) render the same presets.
+
+#define         SAMPLE_PRESETS      6
+
+static const double sample_preset[SAMPLE_PRESETS][4] = {{0.0, 0.75, 0.0, 240.0},
+                                                        {0.0, 0.35, 0.0, 240.0},
+                                                        {1.0, 0.0, 0.0, 240.0},
+                                                        {0.75, 0.75, 0.0, 240.0},
+                                                        {1.0, 0.0, 0.0, 315.0},
+                                                        {1.0, 0.0, 315.0, 120.0}};
+
+
 typedef struct
 {
   int32_t       window_x;
@@ -84,7 +97,6 @@ typedef struct
   double        start_hsv;
   double        end_hsv;
   SUN_OPT       sunopts;
-  QColor        color_array[NUMSHADES * (NUMHUES + 1)];
   int16_t       sample_data[SAMPLE_HEIGHT][SAMPLE_WIDTH];
   float         sample_min, sample_max;
   QPixmap       sample_pixmap;
@@ -109,5 +121,10 @@ typedef struct
 float sunshade(float *lower_row, float *upper_row, int32_t col_num, SUN_OPT *sunopts,
                     double x_cell_size, double y_cell_size);
 
+void palshd (int num_shades, int num_hues, float start_hue, float end_hue, float min_saturation, float max_saturation,
+             float min_value, float max_value, int start_color, QColor color_array[], uint8_t *rgba = NULL);
+void hsvrgb (float hue, float saturation, float value, QColor *rgb);
+void hsvrgb (float hue, float saturation, float value, uint8_t *rgb);
+
 
 #endif
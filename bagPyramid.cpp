@@ -0,0 +1,290 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#include "bagPyramid.hpp"
+
+
+//  Chunk cache and block sizes for the BAG_READER.  The pyramid is built in one top to bottom pass so a modest
+//  block is plenty.
+
+#define         PYRAMID_CHUNK_CACHE         16777216
+#define         PYRAMID_BLOCK_BYTES         33554432
+
+
+
+//  Mean of the valid cells of each 2 by 2 block of level l - 1.
+
+static uint8_t pool_level (BAG_PYRAMID *pyramid, int32_t l)
+{
+  PYRAMID_LEVEL *above = &pyramid->level[l - 1], *level = &pyramid->level[l];
+
+
+  level->width = (above->width + 1) / 2;
+  level->height = (above->height + 1) / 2;
+  level->factor = above->factor * 2;
+  level->x_cell_size = above->x_cell_size * 2.0;
+  level->y_cell_size = above->y_cell_size * 2.0;
+
+  level->data = (float *) malloc ((int64_t) level->width * level->height * sizeof (float));
+  if (level->data == NULL) return (NVFalse);
+
+
+  for (int32_t i = 0 ; i < level->height ; i++)
+    {
+      for (int32_t j = 0 ; j < level->width ; j++)
+        {
+          float sum = 0.0;
+          int32_t count = 0;
+
+          for (int32_t m = i * 2 ; m < qMin (i * 2 + 2, above->height) ; m++)
+            {
+              for (int32_t n = j * 2 ; n < qMin (j * 2 + 2, above->width) ; n++)
+                {
+                  float depth = above->data[(int64_t) m * above->width + n];
+
+                  if (depth != -NULL_ELEVATION)
+                    {
+                      sum += depth;
+                      count++;
+                    }
+                }
+            }
+
+          level->data[(int64_t) i * level->width + j] = count ? sum / (float) count : -NULL_ELEVATION;
+        }
+    }
+
+  return (NVTrue);
+}
+
+
+
+/*!
+    Read bag_file once and build the pyramid.  If cancel is not NULL and gets set (from another thread) the build
+    stops at the next row.  Returns NVFalse with a message in error (2048 bytes) if the BAG can't be opened or
+    read, the memory can't be allocated, or the build was canceled.  The pyramid is freed on failure.
+*/
+
+uint8_t bag_pyramid_build (BAG_PYRAMID *pyramid, char *bag_file, QAtomicInt *cancel, char *error)
+{
+  bagHandle           bag_handle;
+  bagError            bagErr;
+  BAG_READER          reader;
+  uint8_t             reader_open = NVFalse, status = NVTrue;
+  float               *row = NULL;
+  double              *sum = NULL;
+  int32_t             *count = NULL;
+
+
+  memset (pyramid, 0, sizeof (BAG_PYRAMID));
+
+  if ((bagErr = bagFileOpen (&bag_handle, BAG_OPEN_READONLY, (u8 *) bag_file)) != BAG_SUCCESS)
+    {
+      u8 *errstr;
+
+      if (bagGetErrorString (bagErr, &errstr) == BAG_SUCCESS)
+        {
+          snprintf (error, 2048, "Error opening BAG file : %s", errstr);
+        }
+      else
+        {
+          snprintf (error, 2048, "Error opening BAG file %s", bag_file);
+        }
+
+      return (NVFalse);
+    }
+
+  int32_t cols = bagGetDataPointer (bag_handle)->def.ncols;
+  int32_t rows = bagGetDataPointer (bag_handle)->def.nrows;
+  double x_bin_size_degrees = bagGetDataPointer (bag_handle)->def.nodeSpacingX;
+  double y_bin_size_degrees = bagGetDataPointer (bag_handle)->def.nodeSpacingY;
+
+  pyramid->cols = cols;
+  pyramid->rows = rows;
+
+
+  //  The base level.  The cell sizes are figured the same way bag_convert does it so the shading matches.
+
+  PYRAMID_LEVEL *base = &pyramid->level[0];
+
+  base->factor = qMax (1, (qMax (cols, rows) + PYRAMID_BASE_SIZE - 1) / PYRAMID_BASE_SIZE);
+  base->width = (cols + base->factor - 1) / base->factor;
+  base->height = (rows + base->factor - 1) / base->factor;
+
+  double conversion_factor = cos (rows * y_bin_size_degrees * 0.0174532925199432957692);
+  base->x_cell_size = x_bin_size_degrees * 111120.0 * conversion_factor * base->factor;
+  base->y_cell_size = y_bin_size_degrees * 111120.0 * base->factor;
+
+  base->data = (float *) malloc ((int64_t) base->width * base->height * sizeof (float));
+  row = (float *) malloc ((int64_t) cols * sizeof (float));
+  sum = (double *) calloc (base->width, sizeof (double));
+  count = (int32_t *) calloc (base->width, sizeof (int32_t));
+
+  if (base->data == NULL || row == NULL || sum == NULL || count == NULL)
+    {
+      snprintf (error, 2048, "Error allocating preview memory : %s", strerror (errno));
+      status = NVFalse;
+    }
+
+
+  if (status) reader_open = bag_reader_open (&reader, bag_file, 0, 0, cols, rows, PYRAMID_CHUNK_CACHE, PYRAMID_BLOCK_BYTES);
+
+
+  //  Row 0 of the BAG is the southern row.  Each group of factor rows becomes one base row, stored northern row
+  //  first.
+
+  pyramid->min_val = 999999999.0;
+  pyramid->max_val = -999999999.0;
+
+  for (int32_t i = 0 ; status && i < rows ; i++)
+    {
+      if (cancel && cancel->loadAcquire ())
+        {
+          snprintf (error, 2048, "Preview canceled");
+          status = NVFalse;
+          break;
+        }
+
+      uint8_t got_row;
+
+      if (reader_open)
+        {
+          got_row = bag_reader_get_row (&reader, i, row);
+        }
+      else
+        {
+          got_row = (bagReadRow (bag_handle, i, 0, cols - 1, Elevation, (void *) row) == BAG_SUCCESS);
+        }
+
+      if (!got_row)
+        {
+          snprintf (error, 2048, "Error reading row %d of %s", i, bag_file);
+          status = NVFalse;
+          break;
+        }
+
+      for (int32_t j = 0 ; j < cols ; j++)
+        {
+          if (row[j] != NULL_ELEVATION)
+            {
+              float depth = -row[j];
+
+              sum[j / base->factor] += depth;
+              count[j / base->factor]++;
+
+              pyramid->min_val = qMin (pyramid->min_val, depth);
+              pyramid->max_val = qMax (pyramid->max_val, depth);
+              pyramid->valid_cells++;
+            }
+        }
+
+      if ((i + 1) % base->factor == 0 || i == rows - 1)
+        {
+          float *out = &base->data[(int64_t) (base->height - 1 - i / base->factor) * base->width];
+
+          for (int32_t j = 0 ; j < base->width ; j++) out[j] = count[j] ? (float) (sum[j] / count[j]) : -NULL_ELEVATION;
+
+          memset (sum, 0, base->width * sizeof (double));
+          memset (count, 0, base->width * sizeof (int32_t));
+        }
+    }
+
+  if (reader_open) bag_reader_close (&reader);
+  bagFileClose (bag_handle);
+
+  free (row);
+  free (sum);
+  free (count);
+
+
+  if (status && !pyramid->valid_cells)
+    {
+      snprintf (error, 2048, "%s has no valid cells", bag_file);
+      status = NVFalse;
+    }
+
+
+  //  The rest of the levels.
+
+  if (status)
+    {
+      pyramid->levels = 1;
+
+      while (pyramid->levels < PYRAMID_LEVELS && qMax (pyramid->level[pyramid->levels - 1].width,
+                                                       pyramid->level[pyramid->levels - 1].height) > PYRAMID_MIN_SIZE)
+        {
+          if (!pool_level (pyramid, pyramid->levels))
+            {
+              snprintf (error, 2048, "Error allocating preview memory : %s", strerror (errno));
+              status = NVFalse;
+              break;
+            }
+
+          pyramid->levels++;
+        }
+    }
+
+  if (!status) bag_pyramid_free (pyramid);
+
+  return (status);
+}
+
+
+
+//  The smallest level that still fills a width by height box when it's scaled to fit (keeping its shape).  If
+//  none of them do, level 0.
+
+int32_t bag_pyramid_level (BAG_PYRAMID *pyramid, int32_t width, int32_t height)
+{
+  for (int32_t l = pyramid->levels - 1 ; l > 0 ; l--)
+    {
+      if (pyramid->level[l].width >= width || pyramid->level[l].height >= height) return (l);
+    }
+
+  return (0);
+}
+
+
+
+void bag_pyramid_free (BAG_PYRAMID *pyramid)
+{
+  for (int32_t l = 0 ; l < PYRAMID_LEVELS ; l++) free (pyramid->level[l].data);
+
+  memset (pyramid, 0, sizeof (BAG_PYRAMID));
+}
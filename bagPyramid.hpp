@@ -0,0 +1,93 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#ifndef BAGPYRAMID_H
+#define BAGPYRAMID_H
+
+#include "bagGeotiffDef.hpp"
+#include "bagReader.hpp"
+#include "render.hpp"
+
+
+/*!
+    Downsampled preview pyramid of a BAG for the image page.  The BAG is read once, a row at a time (through a
+    BAG_READER if the elevation layer can be opened that way, otherwise with bagReadRow), and mean pooled into a
+    base level whose longer side is at most PYRAMID_BASE_SIZE cells.  Each level after that is the mean of 2 by 2
+    cells of the one before, down to PYRAMID_MIN_SIZE.  Empty cells are left out of the means and a cell with no
+    valid cells under it is empty.
+
+    The levels are stored the way the renderer wants them, as depths (elevations negated, -NULL_ELEVATION for
+    empty cells) with row 0 the northern row, so rendering a preview of any level with render_image (render.cpp)
+    takes milliseconds and never touches the BAG again.
+*/
+
+#define         PYRAMID_BASE_SIZE           1024
+#define         PYRAMID_MIN_SIZE            32
+#define         PYRAMID_LEVELS              8
+
+
+typedef struct
+{
+  int32_t       width;
+  int32_t       height;
+  int32_t       factor;                     //  BAG cells per level cell in each direction
+  double        x_cell_size;                //  Meters, for sunshading
+  double        y_cell_size;
+  float         *data;                      //  width * height depths, northern row first
+} PYRAMID_LEVEL;
+
+
+typedef struct
+{
+  int32_t       cols;                       //  BAG dimensions
+  int32_t       rows;
+  float         min_val;                    //  Depth range of the BAG's valid cells (not of the means)
+  float         max_val;
+  int64_t       valid_cells;
+  int32_t       levels;
+  PYRAMID_LEVEL level[PYRAMID_LEVELS];
+} BAG_PYRAMID;
+
+
+uint8_t bag_pyramid_build (BAG_PYRAMID *pyramid, char *bag_file, QAtomicInt *cancel, char *error);
+int32_t bag_pyramid_level (BAG_PYRAMID *pyramid, int32_t width, int32_t height);
+void bag_pyramid_free (BAG_PYRAMID *pyramid);
+
+
+#endif
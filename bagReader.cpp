@@ -0,0 +1,253 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "bagReader.hpp"
+
+
+//  HDF5's default chunk cache size.  Used to estimate what bagReadRow costs.
+
+#define DEFAULT_CHUNK_CACHE     1048576
+
+
+
+/*!
+    Open the elevation dataset of the BAG for reading the area starting at x_start, y_start that is width columns
+    by height rows.  chunk_cache is the size of the HDF5 chunk cache in bytes (0 for the HDF5 default) and
+    block_memory is roughly how many bytes to use for the block buffer.  Returns NVFalse if the file or dataset
+    can't be opened, in which case the caller should fall back to bagReadRow.
+*/
+
+uint8_t bag_reader_open (BAG_READER *reader, char *bag_file, int32_t x_start, int32_t y_start, int32_t width, int32_t height,
+                         int64_t chunk_cache, int64_t block_memory)
+{
+  hsize_t             dims[2], chunk[2];
+  hid_t               dapl, dcpl;
+
+
+  memset (reader, 0, sizeof (BAG_READER));
+  reader->file_id = reader->dataset_id = reader->space_id = -1;
+  reader->block_first = -1;
+  reader->last_row = -1;
+
+
+  reader->file_id = H5Fopen (bag_file, H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (reader->file_id < 0) return (NVFalse);
+
+
+  //  Set the chunk cache on the dataset access property list.  The number of slots should be a prime number
+  //  roughly 100 times the number of chunks that fit in the cache.  We just use a large prime.
+
+  dapl = H5Pcreate (H5P_DATASET_ACCESS);
+  if (chunk_cache > 0) H5Pset_chunk_cache (dapl, 12421, (size_t) chunk_cache, 1.0);
+
+  reader->dataset_id = H5Dopen2 (reader->file_id, "/BAG_root/elevation", dapl);
+  H5Pclose (dapl);
+
+  if (reader->dataset_id < 0)
+    {
+      bag_reader_close (reader);
+      return (NVFalse);
+    }
+
+
+  reader->space_id = H5Dget_space (reader->dataset_id);
+
+  if (H5Sget_simple_extent_ndims (reader->space_id) != 2)
+    {
+      bag_reader_close (reader);
+      return (NVFalse);
+    }
+
+  H5Sget_simple_extent_dims (reader->space_id, dims, NULL);
+  reader->rows = (int32_t) dims[0];
+  reader->cols = (int32_t) dims[1];
+
+
+  //  Get the chunk layout.  If the dataset isn't chunked, a "chunk" is one row.
+
+  reader->chunk_rows = 1;
+  reader->chunk_cols = reader->cols;
+
+  dcpl = H5Dget_create_plist (reader->dataset_id);
+
+  if (H5Pget_layout (dcpl) == H5D_CHUNKED && H5Pget_chunk (dcpl, 2, chunk) == 2)
+    {
+      reader->chunk_rows = (int32_t) chunk[0];
+      reader->chunk_cols = (int32_t) chunk[1];
+    }
+
+  H5Pclose (dcpl);
+
+
+  if (x_start < 0 || y_start < 0 || x_start + width > reader->cols || y_start + height > reader->rows)
+    {
+      bag_reader_close (reader);
+      return (NVFalse);
+    }
+
+  reader->x_start = x_start;
+  reader->y_start = y_start;
+  reader->width = width;
+  reader->height = height;
+
+
+  //  Block height is as many whole chunk rows as fit in block_memory (at least one).
+
+  int64_t chunk_row_bytes = (int64_t) reader->chunk_rows * width * sizeof (float);
+
+  reader->block_height = reader->chunk_rows * (int32_t) qMax ((int64_t) 1, block_memory / chunk_row_bytes);
+
+  reader->block = (float *) malloc ((int64_t) reader->block_height * width * sizeof (float));
+
+  if (reader->block == NULL)
+    {
+      bag_reader_close (reader);
+      return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+//  Number of chunks that a read of the area columns from first_row through last_row (dataset rows) touches.
+
+static int64_t chunks_touched (BAG_READER *reader, int32_t first_row, int32_t last_row)
+{
+  int64_t chunk_rows = last_row / reader->chunk_rows - first_row / reader->chunk_rows + 1;
+  int64_t chunk_cols = (reader->x_start + reader->width - 1) / reader->chunk_cols - reader->x_start / reader->chunk_cols + 1;
+
+  return (chunk_rows * chunk_cols);
+}
+
+
+
+/*!
+    Get area row "row" (0 is the southernmost row of the area, just like bagReadRow) into data.  If the row isn't
+    in the current block, the chunk aligned block that contains it is read.
+*/
+
+uint8_t bag_reader_get_row (BAG_READER *reader, int32_t row, float *data)
+{
+  if (row < 0 || row >= reader->height) return (NVFalse);
+
+
+  if (reader->block_first < 0 || row < reader->block_first || row >= reader->block_first + reader->block_rows)
+    {
+      int32_t ds_row = reader->y_start + row, first, last;
+
+
+      //  If we're going down, build the block downward from the end of the chunk that holds this row.  Otherwise
+      //  build it upward from the start of the chunk.
+
+      if (reader->last_row >= 0 && row < reader->last_row)
+        {
+          last = (ds_row / reader->chunk_rows + 1) * reader->chunk_rows - 1;
+          first = last - reader->block_height + 1;
+        }
+      else
+        {
+          first = (ds_row / reader->chunk_rows) * reader->chunk_rows;
+          last = first + reader->block_height - 1;
+        }
+
+      first = qMax (first, reader->y_start);
+      last = qMin (last, reader->y_start + reader->height - 1);
+
+
+      hsize_t offset[2] = {(hsize_t) first, (hsize_t) reader->x_start};
+      hsize_t count[2] = {(hsize_t) (last - first + 1), (hsize_t) reader->width};
+
+      H5Sselect_hyperslab (reader->space_id, H5S_SELECT_SET, offset, NULL, count, NULL);
+
+      hid_t mem_space = H5Screate_simple (2, count, NULL);
+
+      herr_t status = H5Dread (reader->dataset_id, H5T_NATIVE_FLOAT, mem_space, reader->space_id, H5P_DEFAULT, reader->block);
+
+      H5Sclose (mem_space);
+
+      if (status < 0)
+        {
+          reader->block_first = -1;
+          return (NVFalse);
+        }
+
+      reader->block_first = first - reader->y_start;
+      reader->block_rows = last - first + 1;
+      reader->chunk_reads += chunks_touched (reader, first, last);
+    }
+
+  reader->last_row = row;
+
+  memcpy (data, &reader->block[(int64_t) (row - reader->block_first) * reader->width], reader->width * sizeof (float));
+
+  return (NVTrue);
+}
+
+
+
+/*!
+    Estimate how many chunk decompressions reading the area with bagReadRow, one row at a time, would cost for
+    the given number of passes.  If a whole row of chunks fits in the default chunk cache each chunk is only
+    decompressed once per pass, otherwise it is decompressed once for every row that passes through it.
+*/
+
+int64_t bag_reader_row_chunk_reads (BAG_READER *reader, int32_t passes)
+{
+  int64_t chunk_bytes = (int64_t) reader->chunk_rows * reader->chunk_cols * sizeof (float);
+  int64_t chunks_across = chunks_touched (reader, reader->y_start, reader->y_start);
+
+
+  if (reader->chunk_rows == 1 || chunks_across * chunk_bytes <= DEFAULT_CHUNK_CACHE)
+    return (passes * chunks_touched (reader, reader->y_start, reader->y_start + reader->height - 1));
+
+  return ((int64_t) passes * reader->height * chunks_across);
+}
+
+
+
+void bag_reader_close (BAG_READER *reader)
+{
+  if (reader->block) free (reader->block);
+  if (reader->space_id >= 0) H5Sclose (reader->space_id);
+  if (reader->dataset_id >= 0) H5Dclose (reader->dataset_id);
+  if (reader->file_id >= 0) H5Fclose (reader->file_id);
+
+  reader->block = NULL;
+  reader->space_id = reader->dataset_id = reader->file_id = -1;
+}
@@ -0,0 +1,85 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef BAGREADER_H
+#define BAGREADER_H
+
+#include "bagGeotiffDef.hpp"
+
+#include <hdf5.h>
+
+
+/*!
+    Chunk aligned reader for the BAG elevation layer.  Instead of calling bagReadRow a row at a time (which makes
+    HDF5 decompress every chunk once for every row that passes through it unless the whole chunk row fits in the
+    chunk cache) we read blocks of whole chunk rows straight from the /BAG_root/elevation dataset with a single
+    hyperslab read.  Rows can then be requested in any order.  When the rows are requested in descending order
+    (as the render pass does) the blocks are built downward from the chunk containing the requested row so that
+    every chunk is decompressed exactly once per pass.
+*/
+
+typedef struct
+{
+  hid_t         file_id;
+  hid_t         dataset_id;
+  hid_t         space_id;
+  int32_t       rows;                       //  Dimensions of the whole elevation dataset
+  int32_t       cols;
+  int32_t       chunk_rows;                 //  HDF5 chunk dimensions (rows = 1, cols = cols if not chunked)
+  int32_t       chunk_cols;
+  int32_t       x_start;                    //  Area being read, in dataset rows and columns
+  int32_t       y_start;
+  int32_t       width;
+  int32_t       height;
+  int32_t       block_height;               //  Maximum rows in a block (a multiple of chunk_rows)
+  int32_t       block_first;                //  First area row in the block, -1 if the block is empty
+  int32_t       block_rows;                 //  Number of rows in the block
+  int32_t       last_row;                   //  Last row requested, used to guess the read direction
+  float         *block;
+  int64_t       chunk_reads;                //  Number of chunk decompressions done by this reader
+} BAG_READER;
+
+
+uint8_t bag_reader_open (BAG_READER *reader, char *bag_file, int32_t x_start, int32_t y_start, int32_t width, int32_t height,
+                         int64_t chunk_cache, int64_t block_memory);
+uint8_t bag_reader_get_row (BAG_READER *reader, int32_t row, float *data);
+int64_t bag_reader_row_chunk_reads (BAG_READER *reader, int32_t passes);
+void bag_reader_close (BAG_READER *reader);
+
+
+#endif
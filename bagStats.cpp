@@ -0,0 +1,237 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "bagStats.hpp"
+
+
+#define         STATS_HEADER                "bagGeotiff statistics 1"
+
+
+//  Set up the window and range of a new set of statistics with an empty histogram.
+
+void bag_stats_init (BAG_STATS *stats, int32_t x_start, int32_t y_start, int32_t width, int32_t height, uint8_t whole,
+                     float min_val, float max_val)
+{
+  memset (stats, 0, sizeof (BAG_STATS));
+
+  stats->x_start = x_start;
+  stats->y_start = y_start;
+  stats->width = width;
+  stats->height = height;
+  stats->whole = whole;
+  stats->min_val = min_val;
+  stats->max_val = max_val;
+}
+
+
+
+//  Add a row of depths (elevations flipped the way bag_convert renders them, so empty cells are -NULL_ELEVATION)
+//  to the histogram.
+
+void bag_stats_add_row (BAG_STATS *stats, float *depth, int32_t width)
+{
+  float scale = 0.0;
+
+  if (stats->max_val > stats->min_val) scale = (float) STATS_BINS / (stats->max_val - stats->min_val);
+
+
+  for (int32_t j = 0 ; j < width ; j++)
+    {
+      if (depth[j] != -NULL_ELEVATION)
+        {
+          int32_t bin = (int32_t) ((depth[j] - stats->min_val) * scale);
+
+          stats->histogram[qBound (0, bin, STATS_BINS - 1)]++;
+          stats->count++;
+        }
+    }
+}
+
+
+
+//  The header line for the BAG as it is now.
+
+static uint8_t stats_header (char *bag_file, char *header)
+{
+  QFileInfo info (bag_file);
+
+  if (!info.exists ()) return (NVFalse);
+
+  sprintf (header, "%s %lld %lld", STATS_HEADER, (long long) info.size (), (long long) info.lastModified ().toMSecsSinceEpoch ());
+
+  return (NVTrue);
+}
+
+
+
+static void stats_name (char *bag_file, char *name)
+{
+  sprintf (name, "%s.stats", bag_file);
+}
+
+
+
+//  Read one record.  Returns NVFalse at the end of the file or if the record is garbled.
+
+static uint8_t read_record (FILE *fp, BAG_STATS *stats)
+{
+  int32_t whole, bins;
+  long long count, h;
+
+
+  if (fscanf (fp, "%d %d %d %d %d %f %f %lld %d", &stats->x_start, &stats->y_start, &stats->width, &stats->height, &whole,
+              &stats->min_val, &stats->max_val, &count, &bins) != 9 || bins != STATS_BINS) return (NVFalse);
+
+  stats->whole = whole;
+  stats->count = count;
+
+  for (int32_t i = 0 ; i < STATS_BINS ; i++)
+    {
+      if (fscanf (fp, "%lld", &h) != 1) return (NVFalse);
+      stats->histogram[i] = h;
+    }
+
+  return (NVTrue);
+}
+
+
+
+static void write_record (FILE *fp, BAG_STATS *stats)
+{
+  fprintf (fp, "%d %d %d %d %d %.9g %.9g %lld %d", stats->x_start, stats->y_start, stats->width, stats->height, stats->whole,
+           stats->min_val, stats->max_val, (long long) stats->count, STATS_BINS);
+
+  for (int32_t i = 0 ; i < STATS_BINS ; i++) fprintf (fp, " %lld", (long long) stats->histogram[i]);
+
+  fprintf (fp, "\n");
+}
+
+
+
+/*!
+    Look for current statistics for the window in stats (or for the whole grid if stats->whole is set, in which
+    case the window is filled in from the record).  Returns NVTrue and fills in stats if they were found.
+*/
+
+uint8_t bag_stats_load (char *bag_file, BAG_STATS *stats)
+{
+  char name[1060], header[256], line[256];
+  FILE *fp;
+  BAG_STATS rec;
+  uint8_t found = NVFalse;
+
+
+  if (!stats_header (bag_file, header)) return (NVFalse);
+
+  stats_name (bag_file, name);
+
+  if ((fp = fopen (name, "r")) == NULL) return (NVFalse);
+
+
+  //  If the BAG has changed the whole file is stale.
+
+  if (fgets (line, sizeof (line), fp) && !strncmp (line, header, strlen (header)) && line[strlen (header)] == '\n')
+    {
+      while (!found && read_record (fp, &rec))
+        {
+          if (stats->whole ? rec.whole : (rec.x_start == stats->x_start && rec.y_start == stats->y_start &&
+                                          rec.width == stats->width && rec.height == stats->height))
+            {
+              *stats = rec;
+              found = NVTrue;
+            }
+        }
+    }
+
+  fclose (fp);
+
+  return (found);
+}
+
+
+
+/*!
+    Save stats in the BAG's sidecar, replacing any record for the same window and dropping everything if the BAG
+    has changed.  Returns NVFalse if the sidecar can't be written (a read only survey directory, for instance),
+    which just means we'll have to scan again next time.
+*/
+
+uint8_t bag_stats_save (char *bag_file, BAG_STATS *stats)
+{
+  char name[1060], temp[1070], header[256], line[256];
+  FILE *fp, *out;
+  BAG_STATS rec;
+
+
+  if (!stats_header (bag_file, header)) return (NVFalse);
+
+  stats_name (bag_file, name);
+  sprintf (temp, "%s.tmp", name);
+
+  if ((out = fopen (temp, "w")) == NULL) return (NVFalse);
+
+  fprintf (out, "%s\n", header);
+  write_record (out, stats);
+
+
+  //  Keep the other windows if the old file is for the same BAG.
+
+  if ((fp = fopen (name, "r")) != NULL)
+    {
+      if (fgets (line, sizeof (line), fp) && !strncmp (line, header, strlen (header)) && line[strlen (header)] == '\n')
+        {
+          while (read_record (fp, &rec))
+            {
+              if (rec.x_start != stats->x_start || rec.y_start != stats->y_start || rec.width != stats->width ||
+                  rec.height != stats->height) write_record (out, &rec);
+            }
+        }
+
+      fclose (fp);
+    }
+
+  if (fclose (out))
+    {
+      remove (temp);
+      return (NVFalse);
+    }
+
+  remove (name);
+
+  return (!rename (temp, name));
+}
@@ -0,0 +1,88 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef BAGSTATS_H
+#define BAGSTATS_H
+
+#include "bagGeotiffDef.hpp"
+
+
+/*!
+    Statistics sidecar.  The first time a BAG (or an area of it) is converted the min, max, number of valid
+    cells, and a histogram of the depths are saved in BAG_FILE.stats so that later runs (with a different sun
+    angle or colors, say) can skip the min/max pass entirely.  The sidecar is thrown away if the BAG's size or
+    modification time changes.  There is one record per area window (the rectangle of the BAG that was
+    converted), so converting different areas of the same BAG doesn't keep invalidating it.
+
+    The file is text:
+
+    <pre>
+    bagGeotiff statistics 1 BAG_SIZE BAG_MSECS
+    X_START Y_START WIDTH HEIGHT WHOLE MIN MAX COUNT BINS H0 H1 ... H(BINS - 1)
+    ...
+    </pre>
+
+    MIN and MAX are depths (elevations negated, the way bag_convert colors them).  The histogram bins are evenly
+    spaced from MIN to MAX.  WHOLE is 1 if the record is for the entire grid (no area file).
+*/
+
+#define         STATS_BINS                  256
+
+
+typedef struct
+{
+  int32_t       x_start;                    //  Area window in the BAG
+  int32_t       y_start;
+  int32_t       width;
+  int32_t       height;
+  uint8_t       whole;                      //  NVTrue if the window is the entire grid
+  float         min_val;
+  float         max_val;
+  int64_t       count;                      //  Number of valid cells
+  int64_t       histogram[STATS_BINS];
+} BAG_STATS;
+
+
+void bag_stats_init (BAG_STATS *stats, int32_t x_start, int32_t y_start, int32_t width, int32_t height, uint8_t whole,
+                     float min_val, float max_val);
+void bag_stats_add_row (BAG_STATS *stats, float *depth, int32_t width);
+uint8_t bag_stats_load (char *bag_file, BAG_STATS *stats);
+uint8_t bag_stats_save (char *bag_file, BAG_STATS *stats);
+
+
+#endif
@@ -0,0 +1,862 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+/***************************************************************************\
+*                                                                           *
+*   Module Name:        batch                                               *
+*                                                                           *
+*   Purpose:            Command line (headless) front end for the BAG to    *
+*                       GeoTIFF conversion engine.  This lets us run the    *
+*                       conversion on machines that have no display and     *
+*                       drive it from scripts.                              *
+*                                                                           *
+\***************************************************************************/
+
+#include "bagConvert.hpp"
+#include "jobScheduler.hpp"
+#include "bench.hpp"
+#include "golden.hpp"
+#include "version.hpp"
+
+#include <getopt.h>
+
+
+static void usage ()
+{
+  fprintf (stderr, "\n%s\n\n", VERSION);
+  fprintf (stderr, "Usage: bagGeotiff --batch [OPTIONS] BAG_FILE [GEOTIFF_FILE]\n");
+  fprintf (stderr, "       bagGeotiff --batch [OPTIONS] [--list=FILE] BAG_FILE|DIRECTORY|WILDCARD ...\n\n");
+  fprintf (stderr, "Where OPTIONS are:\n\n");
+  fprintf (stderr, "\t--azimuth=AZ\t\tSun azimuth, 0.0 to 360.0 [30.0]\n");
+  fprintf (stderr, "\t--elevation=EL\t\tSun elevation, 0.0 to 90.0 [30.0]\n");
+  fprintf (stderr, "\t--exaggeration=EX\tVertical exaggeration, 1.0 to 10.0 [2.5]\n");
+  fprintf (stderr, "\t--saturation=SAT\tColor saturation, 0.0 to 1.0 [1.0]\n");
+  fprintf (stderr, "\t--value=VAL\t\tColor value, 0.0 to 1.0 [0.0]\n");
+  fprintf (stderr, "\t--start_hue=HUE\t\tStart hue, 0.0 to 360.0 [0.0]\n");
+  fprintf (stderr, "\t--end_hue=HUE\t\tEnd hue, 0.0 to 360.0 [240.0]\n");
+  fprintf (stderr, "\t--transparent\t\tMake empty cells transparent (adds an alpha band)\n");
+  fprintf (stderr, "\t--caris\t\t\tWrite the Caris acceptable (PACKBITS) GeoTIFF format\n");
+  fprintf (stderr, "\t--restart\t\tRestart the color map at the zero boundary [default]\n");
+  fprintf (stderr, "\t--no_restart\t\tColor map is continuous from minimum to maximum\n");
+  fprintf (stderr, "\t--area=AREA_FILE\tLimit the output to the area in AREA_FILE\n");
+  fprintf (stderr, "\t--minmax=SOURCE\t\tWhere the min and max values come from, one of:\n");
+  fprintf (stderr, "\t\t\t\t  spill - read the BAG once, keep the rows for the render pass [default]\n");
+  fprintf (stderr, "\t\t\t\t  metadata - use the BAG min/max elevation attributes (no area file)\n");
+  fprintf (stderr, "\t\t\t\t  scan - read the BAG twice\n");
+  fprintf (stderr, "\t--no_stats\t\tDon't use or save the BAG_FILE.stats min/max and histogram sidecar.\n");
+  fprintf (stderr, "\t\t\t\tThe sidecar is only read with --minmax=spill\n");
+  fprintf (stderr, "\t--spill_memory=MB\tMegabytes of rows to hold in memory before spilling to disk [1024]\n");
+  fprintf (stderr, "\t--threads=N\t\tNumber of render threads, 0 for one per core [0]\n");
+  fprintf (stderr, "\t--row_reads\t\tRead the BAG a row at a time with bagReadRow instead of\n");
+  fprintf (stderr, "\t\t\t\tin chunk aligned blocks\n");
+  fprintf (stderr, "\t--chunk_cache=MB\tHDF5 chunk cache size for block reads, 0 for the HDF5 default [16]\n");
+  fprintf (stderr, "\t--pipeline_memory=MB\tMegabytes of row bands allowed in the read/render/write\n");
+  fprintf (stderr, "\t\t\t\tpipeline at once, 0 to run the stages in turn [256]\n");
+  fprintf (stderr, "\t--memory=MB\t\tMemory budget for all of the conversion buffers (pipeline, read\n");
+  fprintf (stderr, "\t\t\t\tblock, HDF5 and GDAL caches, rows held in memory, tile and\n");
+  fprintf (stderr, "\t\t\t\toverview buffers).  Overrides --spill_memory, --chunk_cache,\n");
+  fprintf (stderr, "\t\t\t\tand --pipeline_memory.  0 for no budget [0]\n");
+  fprintf (stderr, "\t--tiled=SIZE\t\tWrite LZW compressed SIZE by SIZE tiles, SIZE is 256 or 512\n");
+  fprintf (stderr, "\t--cog[=SIZE]\t\tWrite a Cloud Optimized GeoTIFF with SIZE by SIZE tiles and internal\n");
+  fprintf (stderr, "\t\t\t\toverviews, SIZE is 256 or 512 [256].  The tiles are copied into COG\n");
+  fprintf (stderr, "\t\t\t\tlayout at the end, which takes another pass over the output and\n");
+  fprintf (stderr, "\t\t\t\tabout twice its size in disk space\n");
+  fprintf (stderr, "\t--bigtiff=MODE\t\tBIGTIFF creation option, one of NO, IF_NEEDED, IF_SAFER, or YES\n");
+  fprintf (stderr, "\t\t\t\t[IF_SAFER for tiled output, NO for Caris, GDAL's default otherwise]\n");
+  fprintf (stderr, "\t--predictor=N\t\tLZW predictor, 1 for none or 2 for horizontal differencing [1]\n");
+  fprintf (stderr, "\t--fast_shade\t\tUse the SSE/AVX2 row hillshade kernel instead of calling sunshade\n");
+  fprintf (stderr, "\t\t\t\tfor every pixel (faster, a few pixels may be one shade off)\n");
+  fprintf (stderr, "\t--exact_shade\t\tCall sunshade for every pixel [default]\n");
+  fprintf (stderr, "\t--lut_shade\t\tLook the shading up in a table of quantized slopes instead of\n");
+  fprintf (stderr, "\t\t\t\tcomputing it (faster, a few pixels may be one shade off)\n");
+  fprintf (stderr, "\t--check_shade\t\tCompare the row hillshade kernel and the shade lookup table\n");
+  fprintf (stderr, "\t\t\t\tagainst sunshade and exit\n");
+  fprintf (stderr, "\t--report=FILE\t\tTime each stage of the conversion and write a JSON report to FILE\n");
+  fprintf (stderr, "\t\t\t\t(- for stdout).  Only for a single BAG\n");
+  fprintf (stderr, "\t--quiet\t\t\tDon't print progress\n\n");
+  fprintf (stderr, "Benchmarking:\n\n");
+  fprintf (stderr, "\t--bench[=MEGACELLS]\tConvert synthetic smooth, noisy, nulls, and survey line grids of about\n");
+  fprintf (stderr, "\t\t\t\tMEGACELLS million cells each with the other options given and\n");
+  fprintf (stderr, "\t\t\t\treport throughput, peak RSS, and output size [16].  --summary\n");
+  fprintf (stderr, "\t\t\t\twrites them as CSV.  No BAG_FILE is needed\n");
+  fprintf (stderr, "\t--golden[=FILE]\t\tRender the sample data presets and synthetic grids with fixed options\n");
+  fprintf (stderr, "\t\t\t\tand compare the pixel hashes with FILE [the built in copy of\n");
+  fprintf (stderr, "\t\t\t\ticons/golden.txt].  Exits non-zero if any pixels changed\n");
+  fprintf (stderr, "\t--golden_update\t\tWrite the current hashes to the --golden FILE instead\n\n");
+  fprintf (stderr, "Converting more than one BAG:\n\n");
+  fprintf (stderr, "\t--list=FILE\t\tAlso convert the BAGs (or directories or wildcards) listed in FILE\n");
+  fprintf (stderr, "\t--jobs=N\t\tConvert at most N BAGs at once, 0 to let the scheduler decide [0]\n");
+  fprintf (stderr, "\t--output_dir=DIR\tPut the GeoTIFFs in DIR instead of next to the BAGs\n");
+  fprintf (stderr, "\t--summary=FILE\t\tWrite a CSV summary of the results to FILE\n");
+  fprintf (stderr, "\t--cache=FILE\t\tBuild cache.  Skip BAGs whose GeoTIFFs are already up to date\n");
+  fprintf (stderr, "\t\t\t\t(same BAG size and time, same options, output untouched)\n");
+  fprintf (stderr, "\t--cache_hash\t\tKey the build cache on the MD5 of the BAG contents instead of its\n");
+  fprintf (stderr, "\t\t\t\tpath, size, and time (copied or moved BAGs are still up to date)\n");
+  fprintf (stderr, "\t--threads=N\t\tis the total for all of the BAGs, and --spill_memory,\n");
+  fprintf (stderr, "\t\t\t\t--pipeline_memory, and --memory are split between the BAGs\n");
+  fprintf (stderr, "\t\t\t\trunning at once\n\n");
+  fprintf (stderr, "If GEOTIFF_FILE is not specified it will be BAG_FILE.tif.  A directory means all of the .bag\n");
+  fprintf (stderr, "files in it.  Quote wildcards so that the shell doesn't expand them.\n\n");
+  fflush (stderr);
+}
+
+
+
+/*!
+    Check the row hillshade kernel (shade.cpp) against sunshade at every instruction set level this machine
+    supports over a range of sun angles, exaggerations, and cell sizes.  Returns 0 if everything is within
+    SHADE_TOLERANCE.  The shade lookup table (--lut_shade) is approximate by design so its mismatch rates are
+    just reported.
+*/
+
+static int32_t check_shade ()
+{
+  static const char *level_name[3] = {"scalar", "SSE", "AVX2"};
+  double              cell_size[3] = {1.0, 185.0, 2000.0};
+  CONVERT_PARAMS      params;
+  SUN_OPT             sunopts;
+  float               diff, worst = 0.0;
+  int32_t             failures = 0, tests = 0;
+
+
+  set_convert_defaults (&params);
+
+  int32_t best = shade_row_level ();
+
+  for (int32_t level = best ; level >= SHADE_SCALAR ; level--)
+    {
+      shade_row_set_level (level);
+
+      for (int32_t az = 0 ; az < 360 ; az += 45)
+        {
+          for (int32_t el = 10 ; el <= 90 ; el += 40)
+            {
+              for (int32_t ex = 1 ; ex <= 10 ; ex += 3)
+                {
+                  for (int32_t c = 0 ; c < 3 ; c++)
+                    {
+                      params.azimuth = (double) az;
+                      params.elevation = (double) el;
+                      params.exaggeration = (double) ex;
+                      set_convert_sunopts (&params, &sunopts);
+
+                      tests++;
+
+                      if (!shade_row_check (&sunopts, cell_size[c], cell_size[c], &diff))
+                        {
+                          failures++;
+                          fprintf (stderr, "%s failed : azimuth %d elevation %d exaggeration %d cell size %.1f difference %g\n",
+                                   level_name[level], az, el, ex, cell_size[c], diff);
+                        }
+
+                      if (!(diff <= worst)) worst = diff;
+                    }
+                }
+            }
+        }
+    }
+
+  shade_row_set_level (best);
+
+  fprintf (stderr, "%d of %d row hillshade checks passed, largest difference %g (tolerance %g)\n", tests - failures, tests,
+           worst, SHADE_TOLERANCE);
+
+
+  //  Same sun options and cell sizes for the lookup table.
+
+  double rate, lut_worst = 0.0, lut_total = 0.0;
+  int32_t lut_tests = 0;
+
+  for (int32_t az = 0 ; az < 360 ; az += 45)
+    {
+      for (int32_t el = 10 ; el <= 90 ; el += 40)
+        {
+          for (int32_t ex = 1 ; ex <= 10 ; ex += 3)
+            {
+              for (int32_t c = 0 ; c < 3 ; c++)
+                {
+                  params.azimuth = (double) az;
+                  params.elevation = (double) el;
+                  params.exaggeration = (double) ex;
+                  set_convert_sunopts (&params, &sunopts);
+
+                  if ((rate = shade_lut_check (&sunopts, cell_size[c], cell_size[c])) < 0.0) continue;
+
+                  lut_tests++;
+                  lut_total += rate;
+                  if (rate > lut_worst) lut_worst = rate;
+                }
+            }
+        }
+    }
+
+  if (lut_tests)
+    fprintf (stderr, "Shade lookup table mismatch rate %.4f%% average, %.4f%% worst (%d checks)\n",
+             100.0 * lut_total / (double) lut_tests, 100.0 * lut_worst, lut_tests);
+
+  fflush (stderr);
+
+  return (failures ? -1 : 0);
+}
+
+
+
+//  Only print when the percentage actually changes so that we don't slow down the row loop.
+
+static uint8_t batch_progress (int32_t stage, int32_t value, int32_t max, void *user_data)
+{
+  int32_t *last_percent = (int32_t *) user_data;
+
+
+  int32_t percent = (int32_t) (((float) value / (float) max) * 100.0);
+
+  if (percent != last_percent[stage])
+    {
+      if (stage == CONVERT_MINMAX_STAGE)
+        {
+          fprintf (stderr, "Generating min and max values : %03d%%\r", percent);
+        }
+      else
+        {
+          fprintf (stderr, "Writing GeoTIFF : %03d%%                \r", percent);
+        }
+      fflush (stderr);
+
+      last_percent[stage] = percent;
+    }
+
+  return (NVTrue);
+}
+
+
+
+//  Indices of the options in batch_main's long_options array.  These have to be in the same order as the array
+//  (add new options to the end of both).
+
+enum
+{
+  OPT_BATCH,
+  OPT_AZIMUTH,
+  OPT_ELEVATION,
+  OPT_EXAGGERATION,
+  OPT_SATURATION,
+  OPT_VALUE,
+  OPT_START_HUE,
+  OPT_END_HUE,
+  OPT_TRANSPARENT,
+  OPT_CARIS,
+  OPT_RESTART,
+  OPT_NO_RESTART,
+  OPT_AREA,
+  OPT_QUIET,
+  OPT_MINMAX,
+  OPT_SPILL_MEMORY,
+  OPT_THREADS,
+  OPT_ROW_READS,
+  OPT_CHUNK_CACHE,
+  OPT_EXACT_SHADE,
+  OPT_CHECK_SHADE,
+  OPT_TILED,
+  OPT_BIGTIFF,
+  OPT_PREDICTOR,
+  OPT_COG,
+  OPT_PIPELINE_MEMORY,
+  OPT_JOBS,
+  OPT_LIST,
+  OPT_OUTPUT_DIR,
+  OPT_SUMMARY,
+  OPT_CACHE,
+  OPT_CACHE_HASH,
+  OPT_NO_STATS,
+  OPT_REPORT,
+  OPT_BENCH,
+  OPT_BENCH_CASE,
+  OPT_GOLDEN,
+  OPT_GOLDEN_UPDATE,
+  OPT_MEMORY,
+  OPT_LUT_SHADE,
+  OPT_FAST_SHADE,
+  OPT_COUNT
+};
+
+
+
+//  NVFalse for the options that only make sense to the parent process (--batch, --quiet, the thread and memory
+//  limits, the multiple BAG and benchmark options, and --report).
+
+static uint8_t pass_option (int32_t option_index)
+{
+  switch (option_index)
+    {
+    case OPT_BATCH:
+    case OPT_QUIET:
+    case OPT_SPILL_MEMORY:
+    case OPT_THREADS:
+    case OPT_PIPELINE_MEMORY:
+    case OPT_JOBS:
+    case OPT_LIST:
+    case OPT_OUTPUT_DIR:
+    case OPT_SUMMARY:
+    case OPT_CACHE:
+    case OPT_CACHE_HASH:
+    case OPT_REPORT:
+    case OPT_BENCH:
+    case OPT_BENCH_CASE:
+    case OPT_GOLDEN:
+    case OPT_GOLDEN_UPDATE:
+    case OPT_MEMORY:
+      return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+int32_t batch_main (int32_t argc, char **argv)
+{
+  CONVERT_PARAMS      params;
+  CONVERT_RESULT      result;
+  int32_t             option_index = 0, last_percent[2] = {-1, -1};
+  uint8_t             quiet = NVFalse;
+  JOB_OPTIONS         jobs;
+  char                list_file[1024] = "", report_file[1024] = "", bench_spec[128] = "", golden_file[1024] = "";
+  int32_t             bench_megacells = 0;
+  uint8_t             golden_update = NVFalse;
+  STAGE_TIMES         timing;
+  QStringList         pass_args;
+
+
+  static struct option long_options[] = {{"batch", no_argument, 0, 0},
+                                         {"azimuth", required_argument, 0, 0},
+                                         {"elevation", required_argument, 0, 0},
+                                         {"exaggeration", required_argument, 0, 0},
+                                         {"saturation", required_argument, 0, 0},
+                                         {"value", required_argument, 0, 0},
+                                         {"start_hue", required_argument, 0, 0},
+                                         {"end_hue", required_argument, 0, 0},
+                                         {"transparent", no_argument, 0, 0},
+                                         {"caris", no_argument, 0, 0},
+                                         {"restart", no_argument, 0, 0},
+                                         {"no_restart", no_argument, 0, 0},
+                                         {"area", required_argument, 0, 0},
+                                         {"quiet", no_argument, 0, 0},
+                                         {"minmax", required_argument, 0, 0},
+                                         {"spill_memory", required_argument, 0, 0},
+                                         {"threads", required_argument, 0, 0},
+                                         {"row_reads", no_argument, 0, 0},
+                                         {"chunk_cache", required_argument, 0, 0},
+                                         {"exact_shade", no_argument, 0, 0},
+                                         {"check_shade", no_argument, 0, 0},
+                                         {"tiled", required_argument, 0, 0},
+                                         {"bigtiff", required_argument, 0, 0},
+                                         {"predictor", required_argument, 0, 0},
+                                         {"cog", optional_argument, 0, 0},
+                                         {"pipeline_memory", required_argument, 0, 0},
+                                         {"jobs", required_argument, 0, 0},
+                                         {"list", required_argument, 0, 0},
+                                         {"output_dir", required_argument, 0, 0},
+                                         {"summary", required_argument, 0, 0},
+                                         {"cache", required_argument, 0, 0},
+                                         {"cache_hash", no_argument, 0, 0},
+                                         {"no_stats", no_argument, 0, 0},
+                                         {"report", required_argument, 0, 0},
+                                         {"bench", optional_argument, 0, 0},
+                                         {"bench_case", required_argument, 0, 0},
+                                         {"golden", optional_argument, 0, 0},
+                                         {"golden_update", no_argument, 0, 0},
+                                         {"memory", required_argument, 0, 0},
+                                         {"lut_shade", no_argument, 0, 0},
+                                         {"fast_shade", no_argument, 0, 0},
+                                         {0, no_argument, 0, 0}};
+
+  static_assert (sizeof (long_options) / sizeof (struct option) == OPT_COUNT + 1,
+                 "Every long option needs an OPT_ index (in the same order)");
+
+
+  //  Override the HDF5 version check so that we can read BAGs created with an older version of HDF5.
+
+  putenv ((char *) "HDF5_DISABLE_VERSION_CHECK=2");
+
+
+  set_convert_defaults (&params);
+
+  memset (&jobs, 0, sizeof (JOB_OPTIONS));
+
+
+  while (NVTrue) 
+    {
+      int32_t c = getopt_long (argc, argv, "", long_options, &option_index);
+      if (c == -1) break;
+
+
+      //  Keep the conversion options to pass on to the child processes if we end up converting more than one BAG
+      //  (or benchmarking).  The scheduler sets the threads and memory limits for each child itself.
+
+      if (!c && pass_option (option_index))
+        {
+          QString arg = QString ("--") + QString (long_options[option_index].name);
+          if (optarg) arg += QString ("=") + QString (optarg);
+          pass_args << arg;
+        }
+
+      switch (c) 
+        {
+        case 0:
+
+          switch (option_index)
+            {
+            case OPT_BATCH:
+              break;
+
+            case OPT_AZIMUTH:
+              sscanf (optarg, "%lf", &params.azimuth);
+              break;
+
+            case OPT_ELEVATION:
+              sscanf (optarg, "%lf", &params.elevation);
+              break;
+
+            case OPT_EXAGGERATION:
+              sscanf (optarg, "%lf", &params.exaggeration);
+              break;
+
+            case OPT_SATURATION:
+              sscanf (optarg, "%lf", &params.saturation);
+              break;
+
+            case OPT_VALUE:
+              sscanf (optarg, "%lf", &params.value);
+              break;
+
+            case OPT_START_HUE:
+              sscanf (optarg, "%lf", &params.start_hsv);
+              break;
+
+            case OPT_END_HUE:
+              sscanf (optarg, "%lf", &params.end_hsv);
+              break;
+
+            case OPT_TRANSPARENT:
+              params.transparent = NVTrue;
+              break;
+
+            case OPT_CARIS:
+              params.caris = NVTrue;
+              break;
+
+            case OPT_RESTART:
+              params.restart = NVTrue;
+              break;
+
+            case OPT_NO_RESTART:
+              params.restart = NVFalse;
+              break;
+
+            case OPT_AREA:
+              strncpy (params.area_file, optarg, sizeof (params.area_file) - 1);
+              break;
+
+            case OPT_QUIET:
+              quiet = NVTrue;
+              break;
+
+            case OPT_MINMAX:
+              if (!strcmp (optarg, "spill"))
+                {
+                  params.minmax_source = MINMAX_SPILL;
+                }
+              else if (!strcmp (optarg, "metadata"))
+                {
+                  params.minmax_source = MINMAX_METADATA;
+                }
+              else if (!strcmp (optarg, "scan"))
+                {
+                  params.minmax_source = MINMAX_SCAN;
+                }
+              else
+                {
+                  usage ();
+                  return (-1);
+                }
+              break;
+
+            case OPT_SPILL_MEMORY:
+              sscanf (optarg, "%d", &params.spill_memory);
+              break;
+
+            case OPT_THREADS:
+              sscanf (optarg, "%d", &params.threads);
+              break;
+
+            case OPT_ROW_READS:
+              params.block_reads = NVFalse;
+              break;
+
+            case OPT_CHUNK_CACHE:
+              sscanf (optarg, "%d", &params.chunk_cache);
+              break;
+
+            case OPT_EXACT_SHADE:
+              params.fast_shade = NVFalse;
+              break;
+
+            case OPT_CHECK_SHADE:
+              return (check_shade ());
+
+            case OPT_TILED:
+              params.tiff.mode = TIFF_TILED;
+              sscanf (optarg, "%d", &params.tiff.tile_size);
+              break;
+
+            case OPT_BIGTIFF:
+              {
+                static const char *bigtiff_name[4] = {"NO", "IF_NEEDED", "IF_SAFER", "YES"};
+
+                params.tiff.bigtiff = -2;
+                for (int32_t i = 0 ; i < 4 ; i++) if (!strcasecmp (optarg, bigtiff_name[i])) params.tiff.bigtiff = i;
+
+                if (params.tiff.bigtiff == -2)
+                  {
+                    usage ();
+                    return (-1);
+                  }
+              }
+              break;
+
+            case OPT_PREDICTOR:
+              sscanf (optarg, "%d", &params.tiff.predictor);
+              break;
+
+            case OPT_COG:
+              params.tiff.mode = TIFF_COG;
+              if (optarg) sscanf (optarg, "%d", &params.tiff.tile_size);
+              break;
+
+            case OPT_PIPELINE_MEMORY:
+              sscanf (optarg, "%d", &params.pipeline_memory);
+              break;
+
+            case OPT_JOBS:
+              sscanf (optarg, "%d", &jobs.max_jobs);
+              break;
+
+            case OPT_LIST:
+              strncpy (list_file, optarg, sizeof (list_file) - 1);
+              break;
+
+            case OPT_OUTPUT_DIR:
+              strncpy (jobs.output_dir, optarg, sizeof (jobs.output_dir) - 1);
+              break;
+
+            case OPT_SUMMARY:
+              strncpy (jobs.summary_file, optarg, sizeof (jobs.summary_file) - 1);
+              break;
+
+            case OPT_CACHE:
+              strncpy (jobs.cache_file, optarg, sizeof (jobs.cache_file) - 1);
+              break;
+
+            case OPT_CACHE_HASH:
+              jobs.cache_hash = NVTrue;
+              break;
+
+            case OPT_NO_STATS:
+              params.stats_sidecar = NVFalse;
+              break;
+
+            case OPT_REPORT:
+              strncpy (report_file, optarg, sizeof (report_file) - 1);
+              break;
+
+            case OPT_BENCH:
+              bench_megacells = BENCH_MEGACELLS;
+              if (optarg) sscanf (optarg, "%d", &bench_megacells);
+              if (bench_megacells <= 0)
+                {
+                  usage ();
+                  return (-1);
+                }
+              break;
+
+            case OPT_BENCH_CASE:
+              strncpy (bench_spec, optarg, sizeof (bench_spec) - 1);
+              break;
+
+            case OPT_GOLDEN:
+              strncpy (golden_file, optarg ? optarg : GOLDEN_FILE, sizeof (golden_file) - 1);
+              break;
+
+            case OPT_GOLDEN_UPDATE:
+              golden_update = NVTrue;
+              break;
+
+            case OPT_MEMORY:
+              sscanf (optarg, "%d", &params.memory_budget);
+              break;
+
+            case OPT_LUT_SHADE:
+              params.lut_shade = NVTrue;
+              break;
+
+            case OPT_FAST_SHADE:
+              params.fast_shade = NVTrue;
+              break;
+            }
+          break;
+
+        default:
+          usage ();
+          return (-1);
+        }
+    }
+
+
+  //  Figure out if we're converting one BAG (BAG_FILE [GEOTIFF_FILE]) or a bunch of them.
+
+  QStringList inputs;
+  uint8_t multi = (list_file[0] || jobs.output_dir[0] || jobs.cache_file[0] || argc - optind > 2);
+
+  for (int32_t i = optind ; i < argc ; i++)
+    {
+      QString arg (argv[i]);
+
+      inputs << arg;
+
+      if (QFileInfo (arg).isDir () || arg.contains ("*") || arg.contains ("?") ||
+          (i > optind && arg.toLower ().endsWith (".bag"))) multi = NVTrue;
+    }
+
+
+  //  Make sure we got the input file name.
+
+  uint8_t bench = (bench_megacells || bench_spec[0] || golden_file[0]);
+
+  if ((!bench && !multi && (optind >= argc || optind < argc - 2)) || jobs.max_jobs < 0)
+    {
+      usage ();
+      return (-1);
+    }
+
+  if (!bench && !multi)
+    {
+      strncpy (params.bag_file, argv[optind], sizeof (params.bag_file) - 1);
+
+      if (optind + 1 < argc)
+        {
+          strncpy (params.output_file, argv[optind + 1], sizeof (params.output_file) - 5);
+        }
+      else
+        {
+          snprintf (params.output_file, sizeof (params.output_file) - 4, "%s.tif", params.bag_file);
+        }
+    }
+
+
+  //  Check the ranges the same way the spin boxes in imagePage do.
+
+  if (params.azimuth < 0.0 || params.azimuth > 360.0 || params.elevation < 0.0 || params.elevation > 90.0 ||
+      params.exaggeration < 1.0 || params.exaggeration > 10.0 || params.saturation < 0.0 || params.saturation > 1.0 ||
+      params.value < 0.0 || params.value > 1.0 || params.start_hsv < 0.0 || params.start_hsv > 360.0 ||
+      params.end_hsv < 0.0 || params.end_hsv > 360.0 || params.spill_memory < 0 || params.threads < 0 ||
+      params.chunk_cache < 0 || params.pipeline_memory < 0 || params.memory_budget < 0 ||
+      ((params.tiff.mode == TIFF_TILED || params.tiff.mode == TIFF_COG) && params.tiff.tile_size != 256 &&
+       params.tiff.tile_size != 512) || params.tiff.predictor < 1 || params.tiff.predictor > 2)
+    {
+      fprintf (stderr, "\nOne or more parameters is out of range\n");
+      usage ();
+      return (-1);
+    }
+
+
+  //  The golden image checks (golden.cpp) and benchmarks (bench.cpp) convert synthetic grids instead of BAGs.  The
+  //  golden cases always use their own fixed options.  The children get the same thread and memory
+  //  limits that we would have used.
+
+  if (golden_file[0])
+    {
+      if (golden_update && golden_file[0] == ':')
+        {
+          fprintf (stderr, "\n--golden_update needs a FILE to write.  Use --golden=icons/golden.txt to update the\n");
+          fprintf (stderr, "committed hashes.\n");
+          return (-1);
+        }
+
+      return (run_golden (golden_file, golden_update));
+    }
+
+  if (bench_spec[0]) return (bench_case (&params, bench_spec));
+
+  if (bench_megacells)
+    {
+      if (params.threads) pass_args << QString ("--threads=%1").arg (params.threads);
+      pass_args << QString ("--spill_memory=%1").arg (params.spill_memory) <<
+        QString ("--pipeline_memory=%1").arg (params.pipeline_memory);
+      if (params.memory_budget) pass_args << QString ("--memory=%1").arg (params.memory_budget);
+
+      return (run_benchmarks (argv[0], &pass_args, bench_megacells, jobs.summary_file));
+    }
+
+
+  if (multi)
+    {
+      QStringList bags;
+      char error[2048];
+
+      if (report_file[0])
+        {
+          fprintf (stderr, "\n--report only works when converting a single BAG\n");
+          return (-1);
+        }
+
+      if (!expand_bag_inputs (&inputs, list_file, &bags, error))
+        {
+          fprintf (stderr, "\n%s\n", error);
+          return (-1);
+        }
+
+      jobs.cores = params.threads;
+      jobs.spill_memory = params.spill_memory;
+      jobs.pipeline_memory = params.pipeline_memory;
+      jobs.memory_budget = params.memory_budget;
+      jobs.quiet = quiet;
+
+      return (run_batch_jobs (argv[0], &pass_args, &params, &bags, &jobs));
+    }
+
+
+  if (!quiet)
+    {
+      params.progress = batch_progress;
+      params.user_data = (void *) last_percent;
+    }
+
+
+  if (report_file[0]) params.timing = &timing;
+
+
+  int32_t status = bag_convert (&params, &result);
+
+  if (status != CONVERT_SUCCESS)
+    {
+      fprintf (stderr, "\n%s\n", result.error);
+      fflush (stderr);
+      return (-1);
+    }
+
+  if (result.write_errors)
+    {
+      if (result.failed_row < 0)
+        {
+          fprintf (stderr, "\nUnable to copy the tiles and overviews into COG layout\n");
+        }
+      else
+        {
+          fprintf (stderr, "\n%d TIFF scanline writes failed, last failure on row %d\n", result.write_errors, result.failed_row);
+        }
+    }
+
+  if (report_file[0] && !stage_times_report (&timing, report_file, params.bag_file, result.output_file, result.width,
+                                               result.height))
+    fprintf (stderr, "\nUnable to write the stage report %s : %s\n", report_file, strerror (errno));
+
+  fprintf (stderr, "\nCreated TIFF file %s\n", result.output_file);
+  fprintf (stderr, "%d rows by %d columns\n", result.height, result.width);
+  fprintf (stderr, "%d render threads, %d rows per band, %d bands in the pipeline\n", result.threads, result.band_rows,
+           result.pipeline_bands);
+
+  if (result.fast_shade)
+    {
+      fprintf (stderr, "Row hillshade kernel used (level %d, largest difference from sunshade %g)\n", result.shade_level,
+               result.shade_diff);
+    }
+  else if (params.fast_shade)
+    {
+      fprintf (stderr, "Row hillshade kernel didn't match sunshade (difference %g), used sunshade\n", result.shade_diff);
+    }
+
+  if (result.lut_shade && result.lut_checked)
+    {
+      fprintf (stderr, "Shade lookup table used, %lld of %lld sampled cells (%.4f%%) were a shade off from sunshade\n",
+               (long long) result.lut_mismatches, (long long) result.lut_checked,
+               100.0 * (double) result.lut_mismatches / (double) result.lut_checked);
+    }
+
+  if (params.minmax_source == MINMAX_METADATA && result.minmax_source != MINMAX_METADATA)
+    fprintf (stderr, "BAG min/max metadata not usable, the area was scanned instead\n");
+
+  if (result.area_mask) fprintf (stderr, "Cells outside of the area polygon were masked out\n");
+
+  if (result.minmax_source == MINMAX_STATS) fprintf (stderr, "Min/max read from the statistics sidecar, no min/max pass\n");
+
+  if (result.valid_cells)
+    fprintf (stderr, "%lld valid cells, depths %g to %g\n", (long long) result.valid_cells, result.min_val, result.max_val);
+
+  if (result.block_reads)
+    {
+      fprintf (stderr, "Elevation chunks are %d rows by %d columns\n", result.chunk_rows, result.chunk_cols);
+      fprintf (stderr, "%lld chunk decompressions (the old two pass row by row method would have done about %lld)\n",
+               (long long) result.chunk_reads, (long long) result.row_chunk_reads);
+    }
+  else if (params.block_reads)
+    {
+      fprintf (stderr, "Could not open the elevation layer for block reads, used bagReadRow instead\n");
+    }
+
+  fprintf (stderr, "%.2f seconds writing the GeoTIFF\n", result.write_time);
+  if (result.spill_bytes) fprintf (stderr, "%lld bytes of elevation rows were spilled to disk\n", (long long) result.spill_bytes);
+
+  if (params.memory_budget)
+    {
+      fprintf (stderr, "Memory budget %d MB :", params.memory_budget);
+      for (int32_t i = 0 ; i < MEMORY_PARTS ; i++)
+        fprintf (stderr, " %s %.1f", memory_part_name (i), (double) result.memory.bytes[i] / 1048576.0);
+      fprintf (stderr, " MB\n");
+    }
+
+  fprintf (stderr, "Peak resident set size %.1f MB\n", (double) result.memory.peak_rss / 1024.0);
+
+  fprintf (stderr, "\n");
+  fflush (stderr);
+
+
+  //  Failed writes (or a failed COG copy, which leaves no output at all) mean the GeoTIFF can't be trusted, so the
+  //  job scheduler mustn't count it as done or record it in the build cache.
+
+  return (result.write_errors ? -1 : 0);
+}
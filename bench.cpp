@@ -0,0 +1,217 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "bench.hpp"
+
+
+
+/*!
+    Run one benchmark case in this process.  spec is TYPE,COLS,ROWS (smooth,4096,4096 for instance).  Prints
+
+    <pre>
+    BENCH TYPE COLS ROWS SECONDS CELLS_PER_SECOND PEAK_RSS_KB OUTPUT_BYTES
+    </pre>
+
+    on stdout for run_benchmarks to pick up.
+*/
+
+int32_t bench_case (CONVERT_PARAMS *params, char *spec)
+{
+  SYNTH_GRID grid;
+  CONVERT_SOURCE source;
+  CONVERT_RESULT result;
+  char type[32];
+  QElapsedTimer timer;
+
+
+  if (sscanf (spec, "%31[^,],%d,%d", type, &grid.cols, &grid.rows) != 3 || (grid.type = synth_type (type)) < 0 ||
+      grid.cols < 2 || grid.rows < 2)
+    {
+      fprintf (stderr, "\nBad benchmark case %s\n", spec);
+      return (-1);
+    }
+
+  grid.seed = BENCH_SEED;
+
+  synth_grid_source (&grid, &source);
+  params->source = &source;
+
+  snprintf (params->bag_file, sizeof (params->bag_file), "synthetic %s grid", type);
+  snprintf (params->output_file, sizeof (params->output_file), "%s",
+            QDir (QDir::tempPath ()).filePath (QString ("bagGeotiff_bench_%1_%2.tif").arg (type).
+                                               arg ((qint64) QCoreApplication::applicationPid ())).toLocal8Bit ().constData ());
+
+
+  timer.start ();
+
+  int32_t status = bag_convert (params, &result);
+
+  double seconds = (double) timer.nsecsElapsed () * 1.0e-9;
+
+  if (status != CONVERT_SUCCESS)
+    {
+      fprintf (stderr, "\n%s\n", result.error);
+      return (-1);
+    }
+
+  int64_t output_bytes = QFileInfo (result.output_file).size ();
+  remove (result.output_file);
+
+  printf ("BENCH %s %d %d %.6f %.1f %lld %lld\n", type, grid.cols, grid.rows, seconds,
+          (double) grid.cols * grid.rows / qMax (seconds, 1.0e-9), (long long) peak_rss_kb (), (long long) output_bytes);
+  fflush (stdout);
+
+  return (0);
+}
+
+
+
+//  Grid sizes for megacells million (well, 2^20) cells.
+
+static void case_size (int32_t type, int32_t megacells, int32_t *cols, int32_t *rows)
+{
+  double cells = (double) megacells * 1048576.0;
+
+  if (type == SYNTH_LINE)
+    {
+      *rows = qMax (2, (int32_t) sqrt (cells / 16.0));
+      *cols = *rows * 16;
+    }
+  else
+    {
+      *rows = *cols = qMax (2, (int32_t) sqrt (cells));
+    }
+}
+
+
+
+static void write_bench_summary (BENCH_RESULT *results, char *summary_file)
+{
+  FILE *fp;
+
+  if ((fp = fopen (summary_file, "w")) == NULL)
+    {
+      fprintf (stderr, "Unable to write benchmark summary %s : %s\n", summary_file, strerror (errno));
+      return;
+    }
+
+  fprintf (fp, "grid,cols,rows,status,seconds,cells_per_second,peak_rss_kb,output_bytes\n");
+
+  for (int32_t i = 0 ; i < SYNTH_TYPES ; i++)
+    {
+      fprintf (fp, "%s,%d,%d,%s,%.6f,%.1f,%lld,%lld\n", synth_type_name (results[i].type), results[i].cols, results[i].rows,
+               results[i].status ? "failed" : "ok", results[i].seconds, results[i].cells_per_second,
+               (long long) results[i].peak_rss, (long long) results[i].output_bytes);
+    }
+
+  fclose (fp);
+}
+
+
+
+/*!
+    Run all of the benchmark cases, one child process at a time, and print a table (and optionally write a CSV
+    summary).  pass_args are the conversion options for the children.  Returns 0 if every case ran.
+*/
+
+int32_t run_benchmarks (char *program, QStringList *pass_args, int32_t megacells, char *summary_file)
+{
+  BENCH_RESULT results[SYNTH_TYPES];
+  int32_t status = 0;
+
+
+  fprintf (stderr, "\n%-8s %7s %7s %10s %14s %12s %14s\n", "grid", "cols", "rows", "seconds", "cells/second", "peak RSS KB",
+           "output bytes");
+
+  for (int32_t i = 0 ; i < SYNTH_TYPES ; i++)
+    {
+      BENCH_RESULT *r = &results[i];
+
+      memset (r, 0, sizeof (BENCH_RESULT));
+      r->type = i;
+      r->status = -1;
+
+      case_size (i, megacells, &r->cols, &r->rows);
+
+
+      QStringList args;
+      QProcess proc;
+
+      args << "--batch" << *pass_args << "--quiet" <<
+        QString ("--bench_case=%1,%2,%3").arg (synth_type_name (i)).arg (r->cols).arg (r->rows);
+
+      proc.start (program, args);
+
+      if (proc.waitForStarted () && proc.waitForFinished (-1) && proc.exitStatus () == QProcess::NormalExit &&
+          !proc.exitCode ())
+        {
+          QStringList lines = QString (proc.readAll ()).split ("\n");
+
+          for (int32_t j = 0 ; j < lines.size () ; j++)
+            {
+              char type[32];
+              long long rss, bytes;
+
+              if (sscanf (lines.at (j).toLatin1 ().constData (), "BENCH %31s %*d %*d %lf %lf %lld %lld", type, &r->seconds,
+                          &r->cells_per_second, &rss, &bytes) == 5)
+                {
+                  r->peak_rss = rss;
+                  r->output_bytes = bytes;
+                  r->status = 0;
+                }
+            }
+        }
+
+      if (r->status)
+        {
+          status = -1;
+          fprintf (stderr, "%-8s %7d %7d    FAILED\n", synth_type_name (i), r->cols, r->rows);
+        }
+      else
+        {
+          fprintf (stderr, "%-8s %7d %7d %10.3f %14.0f %12lld %14lld\n", synth_type_name (i), r->cols, r->rows, r->seconds,
+                   r->cells_per_second, (long long) r->peak_rss, (long long) r->output_bytes);
+        }
+
+      fflush (stderr);
+    }
+
+  if (summary_file[0]) write_bench_summary (results, summary_file);
+
+  return (status);
+}
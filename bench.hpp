@@ -0,0 +1,78 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "bagConvert.hpp"
+#include "synthGrid.hpp"
+
+
+/*!
+    Benchmarks (bagGeotiff --batch --bench[=MEGACELLS]).  Each of the synthetic grids in synthGrid.cpp is
+    converted, one at a time, by a child bagGeotiff --batch --bench_case process using whatever conversion options
+    were given on the command line (so --tiled, --cog, --threads, and so on can be compared).  Running each case
+    in its own process keeps the peak resident set size of one case from hiding the next one.  The child converts
+    the grid into a temporary GeoTIFF, prints a BENCH line, and removes the file.
+
+    Everything is reproducible.  The grids are generated from a fixed seed and their sizes only depend on
+    MEGACELLS.  The smooth, noisy, and nulls grids are square and the line grid is 16 times as wide as it is tall.
+*/
+
+#define         BENCH_MEGACELLS             16
+#define         BENCH_SEED                  20200122
+
+
+typedef struct
+{
+  int32_t       type;                       //  SYNTH type
+  int32_t       cols;
+  int32_t       rows;
+  int32_t       status;                     //  0 if the case ran
+  double        seconds;                    //  bag_convert wall time
+  double        cells_per_second;
+  int64_t       peak_rss;                   //  Kilobytes
+  int64_t       output_bytes;
+} BENCH_RESULT;
+
+
+int32_t bench_case (CONVERT_PARAMS *params, char *spec);
+int32_t run_benchmarks (char *program, QStringList *pass_args, int32_t megacells, char *summary_file);
+
+
+#endif
@@ -0,0 +1,248 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "buildCache.hpp"
+#include "version.hpp"
+
+
+//  Size and modification time of a file as a string, empty if it doesn't exist.
+
+static QString file_stamp (QString name)
+{
+  QFileInfo info (name);
+
+  if (!info.exists ()) return (QString ());
+
+  return (QString ("%1 %2").arg ((qint64) info.size ()).arg ((qint64) info.lastModified ().toMSecsSinceEpoch ()));
+}
+
+
+
+//  MD5 of a file's contents, read a megabyte at a time.
+
+static QString file_hash (QString name)
+{
+  QCryptographicHash hash (QCryptographicHash::Md5);
+  QFile file (name);
+  QByteArray data;
+
+
+  if (!file.open (QIODevice::ReadOnly)) return (QString ());
+
+  while (!(data = file.read (1048576)).isEmpty ()) hash.addData (data);
+
+  file.close ();
+
+  return (QString (hash.result ().toHex ()));
+}
+
+
+
+//  The options hash covers everything in the conversion parameters that changes the output, and the version.  It's
+//  made from the parameters after the options were parsed, not the option strings, because later options override
+//  earlier ones (--restart --no_restart is not the same as --no_restart --restart).  The area file is part of the
+//  output too so we add its stamp.
+
+buildCache::buildCache (char *file, CONVERT_PARAMS *params, uint8_t hash_contents)
+{
+  char options[1024];
+
+
+  this->file = QString (file);
+  this->hash_contents = hash_contents;
+
+  snprintf (options, sizeof (options), "%s\ntransparent %d caris %d restart %d\n"
+            "azimuth %.17g elevation %.17g exaggeration %.17g\n"
+            "saturation %.17g value %.17g start_hsv %.17g end_hsv %.17g\n"
+            "minmax %d fast_shade %d lut_shade %d\ntiff %d %d %d %d", VERSION, params->transparent, params->caris,
+            params->restart, params->azimuth, params->elevation, params->exaggeration, params->saturation,
+            params->value, params->start_hsv, params->end_hsv, params->minmax_source, params->fast_shade,
+            params->lut_shade, params->tiff.mode, params->tiff.tile_size, params->tiff.bigtiff, params->tiff.predictor);
+
+  QString all (options);
+
+  if (params->area_file[0])
+    {
+      all += QString ("\narea ") + QFileInfo (params->area_file).absoluteFilePath () + QString (" ") +
+        file_stamp (params->area_file);
+    }
+
+  options_hash = QString (QCryptographicHash::hash (all.toUtf8 (), QCryptographicHash::Md5).toHex ());
+}
+
+
+
+//  Read the cache file.  A missing file is just an empty cache.
+
+uint8_t buildCache::load ()
+{
+  QFile cache (file);
+
+
+  entries.clear ();
+
+  if (!cache.exists ()) return (NVTrue);
+
+  if (!cache.open (QIODevice::ReadOnly)) return (NVFalse);
+
+  while (!cache.atEnd ())
+    {
+      QString line = QString (cache.readLine ()).trimmed ();
+
+      if (line.startsWith ("hash "))
+        {
+          QStringList field = line.split (" ");
+
+          if (field.size () < 5) continue;
+
+          //  The BAG file name is everything after the fourth space (it may have spaces in it).
+
+          int32_t start = 4;
+          for (int32_t i = 0 ; i < 4 ; i++) start += field.at (i).length ();
+
+          hashes.insert (line.mid (start), field.at (1) + QString (" ") + field.at (2) + QString (" ") + field.at (3));
+        }
+      else if (line.length () > 33)
+        {
+          entries.insert (line.left (32), line.mid (33));
+        }
+    }
+
+  cache.close ();
+
+  return (NVTrue);
+}
+
+
+
+//  Write the cache file.  It goes to a temporary file first so a crash can't leave half a cache behind.
+
+uint8_t buildCache::save ()
+{
+  QString temp = file + ".tmp";
+  FILE *fp;
+
+
+  if ((fp = fopen (temp.toLatin1 (), "w")) == NULL) return (NVFalse);
+
+  QList<QString> keys = entries.keys ();
+
+  for (int32_t i = 0 ; i < keys.size () ; i++)
+    {
+      fprintf (fp, "%s %s\n", keys.at (i).toLatin1 ().constData (), entries.value (keys.at (i)).toLatin1 ().constData ());
+    }
+
+  QList<QString> bags = hashes.keys ();
+
+  for (int32_t i = 0 ; i < bags.size () ; i++)
+    {
+      fprintf (fp, "hash %s %s\n", hashes.value (bags.at (i)).toLatin1 ().constData (), bags.at (i).toLatin1 ().constData ());
+    }
+
+  if (fclose (fp)) return (NVFalse);
+
+  QFile::remove (file);
+
+  return (QFile::rename (temp, file));
+}
+
+
+
+//  MD5 of a BAG's contents.  It's only read and hashed again if the BAG's size or modification time has changed
+//  since the last time we hashed it.
+
+QString buildCache::content_hash (char *bag_file)
+{
+  QString path = QFileInfo (bag_file).absoluteFilePath (), stamp = file_stamp (bag_file);
+
+
+  if (stamp.isEmpty ()) return (QString ());
+
+  QString known = hashes.value (path);
+
+  if (known.startsWith (stamp + QString (" "))) return (known.mid (stamp.length () + 1));
+
+  QString md5 = file_hash (bag_file);
+
+  if (!md5.isEmpty ()) hashes.insert (path, stamp + QString (" ") + md5);
+
+  return (md5);
+}
+
+
+
+//  The cache key for converting bag_file to output_file with our options.  With hash_contents the BAG is
+//  identified only by the MD5 of its contents so a copied or moved BAG (or one that lost its time) still matches.
+
+QString buildCache::key (char *bag_file, char *output_file)
+{
+  QString id;
+
+
+  if (hash_contents) id = content_hash (bag_file);
+
+  if (id.isEmpty ()) id = QFileInfo (bag_file).absoluteFilePath () + QString ("\n") + file_stamp (bag_file);
+
+  id += QString ("\n") + options_hash + QString ("\n") + QFileInfo (output_file).absoluteFilePath ();
+
+  return (QString (QCryptographicHash::hash (id.toUtf8 (), QCryptographicHash::Md5).toHex ()));
+}
+
+
+
+//  NVTrue if the output for key was made and hasn't been touched since.
+
+uint8_t buildCache::current (QString key, char *output_file)
+{
+  if (!entries.contains (key)) return (NVFalse);
+
+  QString stamp = file_stamp (output_file);
+
+  if (stamp.isEmpty ()) return (NVFalse);
+
+  return (entries.value (key) == stamp + QString (" ") + QFileInfo (output_file).absoluteFilePath ());
+}
+
+
+
+//  Record a freshly made output.
+
+void buildCache::update (QString key, char *output_file)
+{
+  entries.insert (key, file_stamp (output_file) + QString (" ") + QFileInfo (output_file).absoluteFilePath ());
+}
@@ -0,0 +1,91 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef BUILDCACHE_H
+#define BUILDCACHE_H
+
+#include "bagGeotiffDef.hpp"
+#include "bagConvert.hpp"
+
+
+/*!
+    Build cache for incremental batch runs (bagGeotiff --batch --cache=FILE).  Every GeoTIFF that is made is
+    recorded under a key that is the MD5 of everything that goes into it:
+
+    - the BAG's path, size, and modification time, or with --cache_hash just the MD5 of its contents (for when
+      files get copied or moved around and lose their times)
+    - the conversion parameters that change the output, after the options have been parsed (so the order of
+      the options only matters when it changes the result), and the size and time of the area file
+    - the program version
+    - the output file path
+
+    The entry holds the size and modification time of the GeoTIFF that was made.  A BAG is skipped if its key is
+    in the cache and the GeoTIFF is still there with the same size and time.  With --cache_hash the MD5 of each
+    BAG is kept with the BAG's size and modification time and is only computed again when those change, so a
+    rerun only reads the BAGs that changed.  The cache file is plain text, one "KEY SIZE MSECS OUTPUT_FILE" line
+    per output and one "hash SIZE MSECS MD5 BAG_FILE" line per hashed BAG.
+*/
+
+class buildCache
+{
+public:
+
+  buildCache (char *file, CONVERT_PARAMS *params, uint8_t hash_contents);
+
+  uint8_t load ();
+  uint8_t save ();
+
+  QString key (char *bag_file, char *output_file);
+  uint8_t current (QString key, char *output_file);
+  void update (QString key, char *output_file);
+
+
+protected:
+
+  QString content_hash (char *bag_file);
+
+
+  QString          file, options_hash;
+
+  uint8_t          hash_contents;
+
+  QHash<QString, QString> entries, hashes;
+};
+
+
+#endif
@@ -0,0 +1,98 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "convertThread.hpp"
+
+
+convertThread::convertThread (QObject *parent)
+  : QThread (parent)
+{
+  status = CONVERT_SUCCESS;
+  memset (&result, 0, sizeof (CONVERT_RESULT));
+}
+
+
+
+//  Start converting.  The parameters are copied so the caller's structure doesn't have to stay around.
+
+void convertThread::convert (CONVERT_PARAMS *params)
+{
+  this->params = *params;
+  this->params.progress = thread_progress;
+  this->params.user_data = (void *) this;
+
+  canceled.fetchAndStoreOrdered (0);
+  last_stage = -1;
+
+  start ();
+}
+
+
+
+void convertThread::cancel ()
+{
+  canceled.fetchAndStoreOrdered (1);
+}
+
+
+
+void convertThread::run ()
+{
+  status = bag_convert (&params, &result);
+}
+
+
+
+//  The progress callback (called in this thread).  Only send a signal if it's been long enough since the last one,
+//  the stage changed, or the stage is done, so the GUI thread isn't buried in events on tall rasters.
+
+uint8_t convertThread::thread_progress (int32_t stage, int32_t value, int32_t max, void *user_data)
+{
+  convertThread *thread = (convertThread *) user_data;
+
+
+  if (stage != thread->last_stage || value == max || thread->timer.elapsed () >= PROGRESS_INTERVAL)
+    {
+      thread->last_stage = stage;
+      thread->timer.start ();
+
+      emit thread->progress (stage, value, max);
+    }
+
+  return (!thread->canceled.fetchAndAddOrdered (0));
+}
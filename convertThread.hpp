@@ -0,0 +1,94 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef CONVERTTHREAD_H
+#define CONVERTTHREAD_H
+
+#include "bagGeotiffDef.hpp"
+#include "bagConvert.hpp"
+
+
+/*!
+    Runs bag_convert in its own thread so that the wizard stays responsive (and the Cancel button actually works)
+    while a GeoTIFF is being built.  Progress comes back to the GUI thread through the (queued) progress signal,
+    which is throttled to about 30 updates a second no matter how many rows there are.  Call cancel to stop the
+    conversion.  bag_convert notices at the next progress callback, closes the BAG and the partial GeoTIFF, and
+    returns CONVERT_CANCELED.  The status and result are valid once the QThread finished signal has been sent.
+*/
+
+#define         PROGRESS_INTERVAL           33      //  Milliseconds between progress signals
+
+
+class convertThread : public QThread
+{
+  Q_OBJECT
+
+
+public:
+
+  convertThread (QObject *parent = 0);
+
+  void convert (CONVERT_PARAMS *params);
+  void cancel ();
+
+  int32_t          status;
+
+  CONVERT_RESULT   result;
+
+
+signals:
+
+  void progress (int stage, int value, int max);
+
+
+protected:
+
+  void run ();
+
+  static uint8_t thread_progress (int32_t stage, int32_t value, int32_t max, void *user_data);
+
+  CONVERT_PARAMS   params;
+
+  QAtomicInt       canceled;
+
+  QElapsedTimer    timer;
+
+  int32_t          last_stage;
+};
+
+#endif
@@ -0,0 +1,314 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "golden.hpp"
+#include "version.hpp"
+
+
+#define         GOLDEN_SAMPLE               -1      //  Source is the data.dat sample instead of a synthetic grid
+
+
+typedef struct
+{
+  const char    *name;
+  int32_t       source;                     //  GOLDEN_SAMPLE or a SYNTH type
+  int32_t       preset;                     //  Image page color preset
+  uint8_t       restart;
+  uint8_t       transparent;
+  uint8_t       fast_shade;
+  uint8_t       mask;                       //  Mask with a diamond shaped area
+  int32_t       mode;                       //  TIFF_STRIPPED, TIFF_TILED, or TIFF_COG
+} GOLDEN_CASE;
+
+
+static GOLDEN_CASE golden_case[] = {{"sample_preset_0", GOLDEN_SAMPLE, 0, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"sample_preset_1", GOLDEN_SAMPLE, 1, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"sample_preset_2", GOLDEN_SAMPLE, 2, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"sample_preset_3", GOLDEN_SAMPLE, 3, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"sample_preset_4", GOLDEN_SAMPLE, 4, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"sample_preset_5", GOLDEN_SAMPLE, 5, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"sample_fast_shade", GOLDEN_SAMPLE, 2, NVTrue, NVFalse, NVTrue, NVFalse, TIFF_STRIPPED},
+                                    {"smooth_restart", SYNTH_SMOOTH, 2, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"smooth_no_restart", SYNTH_SMOOTH, 2, NVFalse, NVFalse, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"noisy_tiled", SYNTH_NOISY, 3, NVTrue, NVFalse, NVFalse, NVFalse, TIFF_TILED},
+                                    {"noisy_fast_shade", SYNTH_NOISY, 3, NVTrue, NVFalse, NVTrue, NVFalse, TIFF_STRIPPED},
+                                    {"nulls_transparent", SYNTH_NULLS, 4, NVTrue, NVTrue, NVFalse, NVFalse, TIFF_STRIPPED},
+                                    {"line_cog", SYNTH_LINE, 5, NVTrue, NVTrue, NVFalse, NVFalse, TIFF_COG},
+                                    {"smooth_area_mask", SYNTH_SMOOTH, 0, NVTrue, NVTrue, NVFalse, NVTrue, TIFF_STRIPPED}};
+
+#define         GOLDEN_CASES                ((int32_t) (sizeof (golden_case) / sizeof (GOLDEN_CASE)))
+
+
+
+//  MD5 of the full resolution pixels of a GeoTIFF.  Returns an empty string if it can't be read.
+
+static QString pixel_hash (char *name)
+{
+  GDALDataset *df = (GDALDataset *) GDALOpen (name, GA_ReadOnly);
+
+  if (df == NULL) return (QString ());
+
+  int32_t width = df->GetRasterXSize (), height = df->GetRasterYSize (), bands = df->GetRasterCount ();
+  uint8_t *row = (uint8_t *) malloc ((int64_t) width * bands);
+  QCryptographicHash md5 (QCryptographicHash::Md5);
+  uint8_t ok = (row != NULL);
+
+
+  for (int32_t i = 0 ; ok && i < height ; i++)
+    {
+      if (df->RasterIO (GF_Read, 0, i, width, 1, row, width, 1, GDT_Byte, bands, NULL, bands, (GSpacing) width * bands, 1) !=
+          CE_None)
+        {
+          ok = NVFalse;
+        }
+      else
+        {
+          md5.addData ((const char *) row, width * bands);
+        }
+    }
+
+  free (row);
+  GDALClose ((GDALDatasetH) df);
+
+  if (!ok) return (QString ());
+
+  return (QString (md5.result ().toHex ()));
+}
+
+
+
+//  Write a diamond shaped generic area file (lat, lon per line) inside the source's bounds.
+
+static uint8_t write_diamond (char *area_file, CONVERT_SOURCE *source)
+{
+  FILE *fp;
+
+  if ((fp = fopen (area_file, "w")) == NULL) return (NVFalse);
+
+  double w = source->cols * source->x_spacing, h = source->rows * source->y_spacing;
+  double cx = source->sw_x + w * 0.5, cy = source->sw_y + h * 0.5;
+
+  fprintf (fp, "%.11f, %.11f\n", cy + h * 0.45, cx);
+  fprintf (fp, "%.11f, %.11f\n", cy, cx + w * 0.45);
+  fprintf (fp, "%.11f, %.11f\n", cy - h * 0.45, cx);
+  fprintf (fp, "%.11f, %.11f\n", cy, cx - w * 0.45);
+
+  return (!fclose (fp));
+}
+
+
+
+//  Run one case with the given number of render threads and hash the output.
+
+static QString run_case (GOLDEN_CASE *gc, int32_t threads, SAMPLE_GRID *sample)
+{
+  CONVERT_PARAMS params;
+  CONVERT_RESULT result;
+  CONVERT_SOURCE source;
+  SYNTH_GRID grid;
+  QString temp = QDir (QDir::tempPath ()).filePath (QString ("bagGeotiff_golden_%1_%2").arg (gc->name).
+                                                    arg ((qint64) QCoreApplication::applicationPid ()));
+
+
+  set_convert_defaults (&params);
+
+  params.saturation = sample_preset[gc->preset][0];
+  params.value = sample_preset[gc->preset][1];
+  params.start_hsv = sample_preset[gc->preset][2];
+  params.end_hsv = sample_preset[gc->preset][3];
+  params.restart = gc->restart;
+  params.transparent = gc->transparent;
+  params.fast_shade = gc->fast_shade;
+  params.threads = threads;
+  params.tiff.mode = gc->mode;
+  if (gc->mode != TIFF_STRIPPED) params.tiff.tile_size = 256;
+
+  if (gc->source == GOLDEN_SAMPLE)
+    {
+      sample_grid_source (sample, &source);
+    }
+  else
+    {
+      grid.type = gc->source;
+      grid.cols = grid.rows = GOLDEN_SYNTH_SIZE;
+      grid.seed = GOLDEN_SEED;
+      synth_grid_source (&grid, &source);
+    }
+
+  params.source = &source;
+
+  snprintf (params.bag_file, sizeof (params.bag_file), "%s", gc->name);
+  snprintf (params.output_file, sizeof (params.output_file), "%s.tif", temp.toLocal8Bit ().constData ());
+
+  if (gc->mask)
+    {
+      snprintf (params.area_file, sizeof (params.area_file), "%s.are", temp.toLocal8Bit ().constData ());
+      if (!write_diamond (params.area_file, &source)) return (QString ());
+    }
+
+
+  QString hash;
+
+  if (bag_convert (&params, &result) == CONVERT_SUCCESS && !result.write_errors) hash = pixel_hash (result.output_file);
+
+  remove (result.output_file);
+  if (gc->mask) remove (params.area_file);
+
+  return (hash);
+}
+
+
+
+/*!
+    Run the golden image cases.  If update is set the hashes are written to golden_file, otherwise they are
+    compared with the ones in it.  Returns 0 if everything matched (or was written).
+*/
+
+int32_t run_golden (char *golden_file, uint8_t update)
+{
+  SAMPLE_GRID sample;
+  QHash<QString, QString> golden;
+  QStringList lines;
+  int32_t failed = 0;
+
+
+  if (!sample_grid_read (sample.data, &sample.min_val, &sample.max_val))
+    {
+      fprintf (stderr, "\nUnable to read the sample data resource\n");
+      return (-1);
+    }
+
+
+  //  Read it with QFile so that the built in copy (GOLDEN_FILE) can be read from the resources.  Lines starting
+  //  with # are comments.
+
+  if (!update)
+    {
+      QFile file (golden_file);
+      char name[128], hash[64];
+
+      if (!file.open (QIODevice::ReadOnly | QIODevice::Text))
+        {
+          fprintf (stderr, "\nUnable to open golden file %s\n", golden_file);
+          return (-1);
+        }
+
+      while (!file.atEnd ())
+        {
+          QByteArray line = file.readLine ();
+
+          if (line.isEmpty () || line.constData ()[0] == '#') continue;
+
+          if (sscanf (line.constData (), "%127s %63s", name, hash) == 2) golden.insert (QString (name), QString (hash));
+        }
+
+      file.close ();
+    }
+
+
+  for (int32_t i = 0 ; i < GOLDEN_CASES ; i++)
+    {
+      GOLDEN_CASE *gc = &golden_case[i];
+
+      QString hash = run_case (gc, 0, &sample);
+      QString serial = run_case (gc, 1, &sample);
+      const char *status;
+
+      if (hash.isEmpty () || serial.isEmpty ())
+        {
+          status = "FAILED (conversion)";
+          failed++;
+        }
+      else if (hash != serial)
+        {
+          status = "FAILED (threaded and serial output differ)";
+          failed++;
+        }
+      else if (update)
+        {
+          status = "written";
+          lines << QString ("%1 %2").arg (gc->name).arg (hash);
+        }
+      else if (!golden.contains (gc->name))
+        {
+          status = "FAILED (not in the golden file)";
+          failed++;
+        }
+      else if (golden.value (gc->name) != hash)
+        {
+          status = "FAILED (pixels changed)";
+          failed++;
+        }
+      else
+        {
+          status = "ok";
+        }
+
+      fprintf (stderr, "%-20s %s  %s\n", gc->name, hash.isEmpty () ? "--------------------------------" :
+               hash.toLatin1 ().constData (), status);
+      fflush (stderr);
+    }
+
+
+  if (update && !failed)
+    {
+      FILE *fp;
+
+      if ((fp = fopen (golden_file, "w")) == NULL)
+        {
+          fprintf (stderr, "\nUnable to write golden file %s : %s\n", golden_file, strerror (errno));
+          return (-1);
+        }
+
+      fprintf (fp, "# Golden pixel hashes for bagGeotiff --batch --golden (golden.cpp), one \"NAME MD5\" per line.\n");
+      fprintf (fp, "# Written by %s with --golden_update.\n", VERSION);
+
+      for (int32_t i = 0 ; i < lines.size () ; i++) fprintf (fp, "%s\n", lines.at (i).toLatin1 ().constData ());
+
+      if (fclose (fp))
+        {
+          fprintf (stderr, "\nUnable to write golden file %s : %s\n", golden_file, strerror (errno));
+          return (-1);
+        }
+    }
+
+
+  fprintf (stderr, "\n%d of %d golden cases %s\n", GOLDEN_CASES - failed, GOLDEN_CASES, update ? "written" : "match");
+
+  return (failed ? -1 : 0);
+}
@@ -0,0 +1,77 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include "bagConvert.hpp"
+#include "synthGrid.hpp"
+
+
+/*!
+    Golden image checks (bagGeotiff --batch --golden=FILE).  A fixed set of cases is run through bag_convert, the
+    pixels of each GeoTIFF are read back and hashed (MD5 of the pixel interleaved rows, so the hash doesn't
+    depend on the TIFF layout, compression, or GDAL version), and the hashes are compared with the ones in FILE.
+    Without FILE the hashes committed in icons/golden.txt (built in as the GOLDEN_FILE resource) are used.  Add
+    --golden_update to write FILE from the current build instead.  When a change is supposed to change the
+    pixels, run --golden=icons/golden.txt --golden_update and commit the new hashes with it.
+
+    The cases are the icons/data.dat sample with each of the image page's color presets and the synthetic grids
+    from synthGrid.cpp with and without the color map restart, with transparency, with an area mask, and through
+    the tiled and COG writers, all with the default exact (per pixel sunshade) shading.  The sample and the noisy
+    grid are also rendered once each with --fast_shade so the shade lookup table has coverage.  Each case is also run
+    with one render thread and the hashes have to match, so the threaded render can't drift from the serial one.
+    Nothing is read from a BAG so it needs no data files and takes a few seconds.
+
+    FILE is text, one case per line (lines starting with # are comments):
+
+    <pre>
+    NAME MD5
+    </pre>
+*/
+
+#define         GOLDEN_FILE                 ":/icons/golden.txt"
+
+#define         GOLDEN_SYNTH_SIZE           512
+#define         GOLDEN_SEED                 1
+
+
+int32_t run_golden (char *golden_file, uint8_t update);
+
+
+#endif
@@ -40,17 +40,20 @@
 
 #define FACTOR 255.0
 
-void hsvrgb (float hue, float saturation, float value, QColor *rgb)
+
+/*  Convert HSV to r, g, b in the range 0.0 to 1.0.  */
+
+static void hsv2rgb (float hue, float saturation, float value, float *r, float *g, float *b)
 {
 
-    float           r = 0.0, g = 0.0, b = 0.0, f, p, q, t;
+    float           f, p, q, t;
     int             i;
 
+    *r = *g = *b = 0.0;
+
     if (!saturation)
-      {
-        rgb->setRed ((unsigned short) (value * FACTOR));
-        rgb->setGreen ((unsigned short) (value * FACTOR));
-        rgb->setBlue ((unsigned short) (value * FACTOR));
+    {
+        *r = *g = *b = value;
     }
     else
     {
@@ -65,47 +68,71 @@ void hsvrgb (float hue, float saturation, float value, QColor *rgb)
         switch (i) 
         {
             case 0:
-                r = value;
-                g = t;
-                b = p;
+                *r = value;
+                *g = t;
+                *b = p;
                 break;
 
             case 1:
-                r = q;
-                g = value;
-                b = p;
+                *r = q;
+                *g = value;
+                *b = p;
                 break;
 
             case 2:
-                r = p;
-                g = value;
-                b = t;
+                *r = p;
+                *g = value;
+                *b = t;
                 break;
 
             case 3:
-                r = p;
-                g = q;
-                b = value;
+                *r = p;
+                *g = q;
+                *b = value;
                 break;
 
             case 4:
-                r = t;
-                g = p;
-                b = value;
+                *r = t;
+                *g = p;
+                *b = value;
                 break;
 
             case 5:
-                r = value;
-                g = p;
-                b = q;
+                *r = value;
+                *g = p;
+                *b = q;
                 break;
 
             default:
                 break;
         }
-
-        rgb->setRed ((unsigned short) (r * FACTOR));
-        rgb->setGreen ((unsigned short) (g * FACTOR));
-        rgb->setBlue ((unsigned short) (b *FACTOR));
     }
 }
+
+
+
+void hsvrgb (float hue, float saturation, float value, QColor *rgb)
+{
+    float           r, g, b;
+
+    hsv2rgb (hue, saturation, value, &r, &g, &b);
+
+    rgb->setRed ((unsigned short) (r * FACTOR));
+    rgb->setGreen ((unsigned short) (g * FACTOR));
+    rgb->setBlue ((unsigned short) (b * FACTOR));
+}
+
+
+
+/*  Same as above but for a packed byte R, G, B array.  */
+
+void hsvrgb (float hue, float saturation, float value, uint8_t *rgb)
+{
+    float           r, g, b;
+
+    hsv2rgb (hue, saturation, value, &r, &g, &b);
+
+    rgb[0] = (uint8_t) ((unsigned short) (r * FACTOR));
+    rgb[1] = (uint8_t) ((unsigned short) (g * FACTOR));
+    rgb[2] = (uint8_t) ((unsigned short) (b * FACTOR));
+}
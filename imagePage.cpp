@@ -44,6 +44,26 @@ imagePage::imagePage (QWidget *parent, OPTIONS *op):
 {
   options = op;
   hold_display = NVFalse;
+  preview_ready = NVFalse;
+
+
+  //  The preview pyramid of the BAG is built in the background (previewThread.cpp).
+
+  preview = new previewThread (this);
+  connect (preview, SIGNAL (finished ()), this, SLOT (slotPreviewDone ()));
+
+
+  //  Parameter changes are coalesced by render_timer and the preview is rendered in the background
+  //  (renderThread.cpp) so holding down a spin box arrow doesn't pile up redraws.
+
+  renderer = new renderThread (this);
+  connect (renderer, SIGNAL (rendered (QImage, int)), this, SLOT (slotPreviewRendered (QImage, int)));
+  render_generation = 0;
+
+  render_timer = new QTimer (this);
+  render_timer->setSingleShot (true);
+  render_timer->setInterval (PREVIEW_DELAY);
+  connect (render_timer, SIGNAL (timeout ()), this, SLOT (slotRenderTimer ()));
 
 
   setTitle (tr ("Image parameters"));
@@ -263,10 +283,27 @@ imagePage::imagePage (QWidget *parent, OPTIONS *op):
 
   sample_label = new QLabel (sBox);
   sample_label->setPixmap (options->sample_pixmap);
+  sample_label->setWhatsThis (previewText);
   sample_label->show ();
   sBoxRightLayout->addWidget (sample_label);
 
 
+  //  What the sample is showing, the sample data or a preview of the BAG.
+
+  preview_label = new QLabel (tr ("Sample data"), sBox);
+  preview_label->setToolTip (tr ("The sample shows a preview of the BAG once it has been read"));
+  preview_label->setWordWrap (true);
+  sBoxRightLayout->addWidget (preview_label);
+
+
+  //  Depth range of the BAG from its statistics sidecar (bagStats.cpp), if it has been converted before.
+
+  stats_label = new QLabel (sBox);
+  stats_label->setToolTip (tr ("Depth range of the BAG from the last time it was converted"));
+  stats_label->setWordWrap (true);
+  sBoxRightLayout->addWidget (stats_label);
+
+
   hbox->addWidget (sBox);
 
 
@@ -310,6 +347,15 @@ imagePage::imagePage (QWidget *parent, OPTIONS *op):
   vbox->addWidget (fBox);
 
 
+  //  The sample data flipped to depths, northern row first, the way render_image wants it.
+
+  for (int32_t i = 0 ; i < SAMPLE_HEIGHT ; i++)
+    {
+      for (int32_t j = 0 ; j < SAMPLE_WIDTH ; j++)
+        sample_rows[(SAMPLE_HEIGHT - 1 - i) * SAMPLE_WIDTH + j] = (float) options->sample_data[i][j];
+    }
+
+
   display_sample_data ();
 
 
@@ -327,104 +373,182 @@ imagePage::imagePage (QWidget *parent, OPTIONS *op):
 
 
 
-//  We don't really care about the value, we just want to trigger the redraw of the sample.
+//  The BAG may have changed since the last time we were here.
 
-void imagePage::slotParamChanged (double d __attribute__ ((unused)))
+void imagePage::initializePage ()
 {
-  //  Don't trigger every time slotSampleGroupClicked (below) changes a parameter.
+  display_bag_stats ();
+  start_preview ();
+}
 
-  if (!hold_display) display_sample_data ();
+
+
+//  Going back to the start page.  Stop reading the BAG since the start page may open it too (HDF5 isn't thread
+//  safe).
+
+void imagePage::cleanupPage ()
+{
+  stop_preview ();
+
+  QWizardPage::cleanupPage ();
 }
 
 
 
-void imagePage::slotSampleGroupClicked (int id)
+//  Same thing going on to the conversion.
+
+bool imagePage::validatePage ()
 {
-  hold_display = NVTrue;
+  stop_preview ();
+
+  return (true);
+}
+
+
 
-  switch (id)
+//  Start building the preview pyramid of the BAG unless we already have it (or are already building it).  The
+//  sample data is shown until it's done.
+
+void imagePage::start_preview ()
+{
+  char bag_file[1024];
+
+
+  strncpy (bag_file, field ("bag_file_edit").toString ().toLocal8Bit ().constData (), sizeof (bag_file) - 1);
+  bag_file[sizeof (bag_file) - 1] = 0;
+
+  if (!strcmp (bag_file, preview->bag_file) && (preview_ready || preview->isRunning ())) return;
+
+  stop_preview ();
+
+  preview_ready = NVFalse;
+
+  if (bag_file[0])
     {
-    case 0:
-      satSpin->setValue (0.0);
-      valSpin->setValue (0.75);
-      startSpin->setValue (0.0);
-      endSpin->setValue (240.0);
+      preview_label->setText (tr ("Reading %1 for the preview...").arg (QFileInfo (bag_file).fileName ()));
+      preview->build (bag_file);
+    }
 
-      break;
+  display_sample_data ();
+}
 
-    case 1:
-      satSpin->setValue (0.0);
-      valSpin->setValue (0.35);
-      startSpin->setValue (0.0);
-      endSpin->setValue (240.0);
 
-      break;
 
-    case 2:
-      satSpin->setValue (1.0);
-      valSpin->setValue (0.0);
-      startSpin->setValue (0.0);
-      endSpin->setValue (240.0);
+void imagePage::stop_preview ()
+{
+  if (preview->isRunning ())
+    {
+      preview->cancel ();
+      preview->wait ();
 
-      break;
+      preview_label->setText (tr ("Sample data"));
+    }
+}
 
-    case 3:
-      satSpin->setValue (0.75);
-      valSpin->setValue (0.75);
-      startSpin->setValue (0.0);
-      endSpin->setValue (240.0);
 
-      break;
 
-    case 4:
-      satSpin->setValue (1.0);
-      valSpin->setValue (0.0);
-      startSpin->setValue (0.0);
-      endSpin->setValue (315.0);
+//  The pyramid build finished (or failed, or was canceled).
 
-      break;
+void imagePage::slotPreviewDone ()
+{
+  //  A canceled build can finish after the next one has started.
 
-    case 5:
-      satSpin->setValue (1.0);
-      valSpin->setValue (0.0);
-      startSpin->setValue (315.0);
-      endSpin->setValue (120.0);
+  if (preview->isRunning ()) return;
 
-      break;
+  if (!preview->status)
+    {
+      preview_label->setText (tr ("Sample data (no preview : %1)").arg (QString (preview->error)));
+      return;
     }
 
-  hold_display = NVFalse;
+  preview_ready = NVTrue;
+
+  BAG_PYRAMID *pyramid = &preview->pyramid;
+
+  preview_label->setText (tr ("Preview of %1, %2 by %3 cells").arg (QFileInfo (preview->bag_file).fileName ()).
+                          arg (pyramid->cols).arg (pyramid->rows));
 
   display_sample_data ();
 }
 
 
 
-void imagePage::display_sample_data ()
+//  Show the depth range and histogram peak of the whole BAG if there is a current statistics sidecar for it.
+//  This costs one small text file read, not a pass through the BAG.
+
+void imagePage::display_bag_stats ()
 {
-  float               row[2][SAMPLE_WIDTH], range[2] = {0.0, 0.0}, shade_factor;
-  int32_t             c_index = 0, hue, sat;
-  uint8_t             cross_zero = NVFalse;
+  BAG_STATS stats;
+  char bag_file[1024];
 
-  void palshd (int num_shades, int num_hues, float start_hue, float end_hue, 
-               float min_saturation, float max_saturation, float min_value, 
-               float max_value, int start_color, QColor color_array[]);
 
+  strncpy (bag_file, field ("bag_file_edit").toString ().toLocal8Bit ().constData (), sizeof (bag_file) - 1);
+  bag_file[sizeof (bag_file) - 1] = 0;
 
-  if (restart_check->checkState () && options->sample_min < 0.0)
-    {
-      range[0] = -options->sample_min;
-      range[1] = options->sample_max;
+  memset (&stats, 0, sizeof (BAG_STATS));
+  stats.whole = NVTrue;
 
-      cross_zero = NVTrue;
-    }
-  else
+  if (!bag_file[0] || !bag_stats_load (bag_file, &stats))
     {
-      range[0] = options->sample_max - options->sample_min;
+      stats_label->setText (tr ("Depth range not known until the BAG has been converted once"));
+      return;
+    }
+
+
+  int32_t peak = 0;
+  for (int32_t i = 1 ; i < STATS_BINS ; i++) if (stats.histogram[i] > stats.histogram[peak]) peak = i;
+
+  float bin_size = (stats.max_val - stats.min_val) / (float) STATS_BINS;
+
+  stats_label->setText (tr ("Depths %1 to %2, %3 valid cells, most near %4").arg (stats.min_val, 0, 'f', 2).
+                        arg (stats.max_val, 0, 'f', 2).arg ((qint64) stats.count).
+                        arg (stats.min_val + ((float) peak + 0.5) * bin_size, 0, 'f', 2));
+}
+
+
+
+//  We don't really care about the value, we just want to trigger the redraw of the sample.  Restarting the timer
+//  means a burst of changes only causes one redraw, after the last one.
+
+void imagePage::slotParamChanged (double d __attribute__ ((unused)))
+{
+  //  Don't trigger every time slotSampleGroupClicked (below) changes a parameter.
+
+  if (!hold_display) render_timer->start ();
+}
+
+
+
+void imagePage::slotRenderTimer ()
+{
+  display_sample_data ();
+}
+
 
-      cross_zero = NVFalse;
+
+void imagePage::slotSampleGroupClicked (int id)
+{
+  hold_display = NVTrue;
+
+  if (id >= 0 && id < SAMPLE_PRESETS)
+    {
+      satSpin->setValue (sample_preset[id][0]);
+      valSpin->setValue (sample_preset[id][1]);
+      startSpin->setValue (sample_preset[id][2]);
+      endSpin->setValue (sample_preset[id][3]);
     }
 
+  hold_display = NVFalse;
+
+  render_timer->start ();
+}
+
+
+
+void imagePage::display_sample_data ()
+{
+  int32_t             hue, sat;
+
 
   options->sunopts.azimuth = sunAz->value ();
   options->sunopts.elevation = sunEl->value ();
@@ -435,15 +559,18 @@ void imagePage::display_sample_data ()
   options->sunopts.sun = sun_unv (options->sunopts.azimuth, options->sunopts.elevation);
 
 
-  palshd (NUMSHADES, NUMHUES, (float) endSpin->value (), (float) startSpin->value (), 
-          (float) satSpin->value (), (float) satSpin->value (), (float) valSpin->value (),
-          1.0, 0, options->color_array);
+  //  The palette only changes with the colors, changing the sun options just gets it back out of the cache.
+
+  palette_get (satSpin->value (), valSpin->value (), startSpin->value (), endSpin->value (), preview_palette);
 
 
   //  Set the start and end label background colors
 
-  hue = options->color_array[(NUMHUES - 1) * NUMSHADES].hue ();
-  sat = options->color_array[(NUMHUES - 1) * NUMSHADES].saturation ();
+  uint8_t *rgba = &preview_palette[(NUMHUES - 1) * NUMSHADES * 4];
+  QColor start_color (rgba[0], rgba[1], rgba[2]);
+
+  hue = start_color.hue ();
+  sat = start_color.saturation ();
   if (hue > 210 && hue < 280 && sat > 128)
     {
       startPalette.setColor (QPalette::Normal, QPalette::WindowText, Qt::white);
@@ -454,13 +581,15 @@ void imagePage::display_sample_data ()
       startPalette.setColor (QPalette::Normal, QPalette::WindowText, Qt::black);
       startPalette.setColor (QPalette::Inactive, QPalette::WindowText, Qt::black);
     }
-  startPalette.setColor (QPalette::Normal, QPalette::Window, options->color_array[(NUMHUES - 1) * NUMSHADES]);
-  startPalette.setColor (QPalette::Inactive, QPalette::Window, options->color_array[(NUMHUES - 1) * NUMSHADES]);
+  startPalette.setColor (QPalette::Normal, QPalette::Window, start_color);
+  startPalette.setColor (QPalette::Inactive, QPalette::Window, start_color);
   startLabel->setPalette (startPalette);
 
 
-  hue = options->color_array[0].hue ();
-  sat = options->color_array[0].saturation ();
+  QColor end_color (preview_palette[0], preview_palette[1], preview_palette[2]);
+
+  hue = end_color.hue ();
+  sat = end_color.saturation ();
   if (hue > 210 && hue < 280 && sat > 128)
     {
       endPalette.setColor (QPalette::Normal, QPalette::WindowText, Qt::white);
@@ -471,73 +600,98 @@ void imagePage::display_sample_data ()
       endPalette.setColor (QPalette::Normal, QPalette::WindowText, Qt::black);
       endPalette.setColor (QPalette::Inactive, QPalette::WindowText, Qt::black);
     }
-  endPalette.setColor (QPalette::Normal, QPalette::Window, options->color_array[0]);
-  endPalette.setColor (QPalette::Inactive, QPalette::Window, options->color_array[0]);
+  endPalette.setColor (QPalette::Normal, QPalette::Window, end_color);
+  endPalette.setColor (QPalette::Inactive, QPalette::Window, end_color);
   endLabel->setPalette (endPalette);
 
 
-  QBrush brush;
-  options->sample_pixmap.fill (this, 0, 0);
+  //  Once we have the preview pyramid we show the BAG itself instead of the sample data.  The sample cell sizes
+  //  are hardwired for the sample data in icons/data.dat.
 
-  QPainter painter;
-  painter.begin (&options->sample_pixmap);
+  if (preview_ready)
+    {
+      BAG_PYRAMID *pyramid = &preview->pyramid;
+      PYRAMID_LEVEL *level = &pyramid->level[bag_pyramid_level (pyramid, SAMPLE_WIDTH, SAMPLE_HEIGHT)];
+
+      render_preview (level->data, level->width, level->height, pyramid->min_val, pyramid->max_val, level->x_cell_size,
+                      level->y_cell_size);
+    }
+  else
+    {
+      render_preview (sample_rows, SAMPLE_WIDTH, SAMPLE_HEIGHT, options->sample_min, options->sample_max, 185.0, 185.0);
+    }
+}
 
 
-  for (int32_t i = 0 ; i < SAMPLE_HEIGHT ; i++)
+
+/*!
+    Render height rows of width depths (northern row first) into the sample area with the same kernel, min/max
+    handling, and (exact, per pixel) sunshading as bag_convert, scaled to fit.  This is used for both the sample data and
+    the levels of the BAG preview pyramid.  The palette and sun options have already been set up by
+    display_sample_data.  The rendering is done by the renderThread, which cancels whatever it was doing, and
+    the image shows up in slotPreviewRendered.
+*/
+
+void imagePage::render_preview (float *rows, int32_t width, int32_t height, float min_val, float max_val,
+                                double x_cell_size, double y_cell_size)
+{
+  PREVIEW_JOB         job;
+
+
+  memset (&job, 0, sizeof (PREVIEW_JOB));
+
+  RENDER_PARAMS *rp = &job.rp;
+
+  rp->width = width;
+  rp->min_val = min_val;
+
+  if (restart_check->checkState () && min_val < 0.0)
     {
-      for (int32_t j = 0 ; j < SAMPLE_WIDTH ; j++)
-        {
-          if (i) row[0][j] = row[1][j];
-          row[1][j] = (float) options->sample_data[i][j];
-        }
-
-      if (i && i < SAMPLE_HEIGHT)
-        {
-          for (int32_t k = 0 ; k < SAMPLE_WIDTH ; k++)
-            {
-              if (cross_zero)
-                {
-                  if (row[0][k] < 0.0)
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((row[0][k] - options->sample_min) / range[0] * 
-                                                                         NUMHUES))) * NUMSHADES;
-                    }
-                  else
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf (row[0][k]) / range[1] * NUMHUES)) *
-                        NUMSHADES;
-                    }
-                }
-              else
-                {
-                  c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((row[0][k] - options->sample_min) / range[0] * NUMHUES))) *
-                    NUMSHADES;
-                }
-
-
-              //  IMPORTANT NOTE: The cell sizes are hardwired for the sample data in icons/data.dat.  I wouldn't
-              //  recommend trying to change any of this.
-
-              shade_factor = sunshade (row[0], row[1], k, &options->sunopts, 185.0, 185.0);
-
-              if (shade_factor < 0.0) shade_factor = options->sunopts.min_shade;
-
-              if (shade_factor > 1.0) shade_factor = 1.0;
-
-              c_index -= NINT (NUMSHADES * shade_factor + 0.5);
-
-
-              painter.setPen (Qt::NoPen);
-
-              brush.setStyle (Qt::SolidPattern);
-              brush.setColor (options->color_array[c_index]);
-              painter.setPen (options->color_array[c_index]);
-
-              painter.fillRect (k, SAMPLE_HEIGHT - i, 1, 1, brush);
-            }
-        }
+      rp->range[0] = -min_val;
+      rp->range[1] = max_val;
+
+      rp->cross_zero = NVTrue;
     }
+  else
+    {
+      rp->range[0] = max_val - min_val;
 
+      rp->cross_zero = NVFalse;
+    }
+
+  rp->x_cell_size = x_cell_size;
+  rp->y_cell_size = y_cell_size;
+  rp->sunopts = options->sunopts;
+  rp->fast_shade = NVFalse;
+  rp->bands = 4;
+
+  memcpy (job.palette, preview_palette, sizeof (job.palette));
+
+  job.rows = (float *) malloc ((int64_t) width * height * sizeof (float));
+  if (job.rows == NULL) return;
+
+  memcpy (job.rows, rows, (int64_t) width * height * sizeof (float));
+  job.height = height;
+  job.box_width = SAMPLE_WIDTH;
+  job.box_height = SAMPLE_HEIGHT;
+
+  render_generation = renderer->render (&job);
+}
+
+
+
+//  A finished preview image.  Only the finished image is drawn, never a pixel at a time, and only if nothing
+//  newer has been asked for since.
+
+void imagePage::slotPreviewRendered (QImage image, int generation)
+{
+  if (generation != render_generation) return;
+
+  options->sample_pixmap.fill (this, 0, 0);
+
+  QPainter painter;
+  painter.begin (&options->sample_pixmap);
+  painter.drawImage ((SAMPLE_WIDTH - image.width ()) / 2, (SAMPLE_HEIGHT - image.height ()) / 2, image);
   painter.end ();
 
   sample_label->setPixmap (options->sample_pixmap);
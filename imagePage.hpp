@@ -41,6 +41,13 @@
 
 
 #include "bagGeotiffDef.hpp"
+#include "bagStats.hpp"
+#include "previewThread.hpp"
+#include "renderThread.hpp"
+#include "paletteCache.hpp"
+
+
+#define         PREVIEW_DELAY               40      //  Milliseconds without a parameter change before we redraw
 
 
 class imagePage:public QWizardPage
@@ -58,14 +65,36 @@ signals:
 
 protected:
 
+  void initializePage ();
+  void cleanupPage ();
+  bool validatePage ();
   void display_sample_data ();
+  void display_bag_stats ();
+  void start_preview ();
+  void stop_preview ();
+  void render_preview (float *rows, int32_t width, int32_t height, float min_val, float max_val, double x_cell_size,
+                       double y_cell_size);
 
 
   OPTIONS          *options;
 
   uint8_t          hold_display;
 
-  QLabel           *sample_label, *startLabel, *endLabel;
+  previewThread    *preview;
+
+  renderThread     *renderer;
+
+  QTimer           *render_timer;
+
+  int32_t          render_generation;
+
+  uint8_t          preview_ready;
+
+  uint8_t          preview_palette[PALETTE_COLORS * 4];
+
+  float            sample_rows[SAMPLE_HEIGHT * SAMPLE_WIDTH];
+
+  QLabel           *sample_label, *preview_label, *stats_label, *startLabel, *endLabel;
 
   QCheckBox        *restart_check;
 
@@ -79,6 +108,9 @@ protected slots:
 
   void slotParamChanged (double d __attribute__ ((unused)));
   void slotSampleGroupClicked (int id);
+  void slotPreviewDone ();
+  void slotRenderTimer ();
+  void slotPreviewRendered (QImage image, int generation);
 
 
 private:
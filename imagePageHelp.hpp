@@ -71,6 +71,12 @@ QString sampleText =
   imagePage::tr ("These are some sample color settings.  Selecting one of the buttons will set the colors in the fields "
                  "to the left and redraw the sample to the right.");
 
+QString previewText = 
+  imagePage::tr ("This shows what the GeoTIFF will look like with the settings to the left.  Until the BAG has been "
+                 "read (which is done in the background) it shows some sample data.  After that it shows a reduced "
+                 "view of the whole BAG that is redrawn whenever any of the settings change.  The colors are spread "
+                 "over the depth range of the whole BAG, so they may differ a bit if you are using an area file.");
+
 QString sample0Text = 
   imagePage::tr ("Sets the color values to produce a light grayscale image.");
 
@@ -0,0 +1,482 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "jobScheduler.hpp"
+
+
+//  Add the BAGs matching one argument.  A directory means every .bag file in it, a name with * or ? in it is a
+//  wildcard (in the file name part only), and anything else is taken as a BAG file name.
+
+static void add_bag_input (QString arg, QStringList *bags)
+{
+  QFileInfo info (arg);
+  QStringList names;
+
+
+  if (info.isDir ())
+    {
+      QDir dir (arg);
+
+      names = dir.entryList (QStringList ("*.bag"), QDir::Files, QDir::Name);
+
+      for (int32_t i = 0 ; i < names.size () ; i++) bags->append (dir.absoluteFilePath (names.at (i)));
+    }
+  else if (info.fileName ().contains ("*") || info.fileName ().contains ("?"))
+    {
+      QDir dir = info.dir ();
+
+      names = dir.entryList (QStringList (info.fileName ()), QDir::Files, QDir::Name);
+
+      for (int32_t i = 0 ; i < names.size () ; i++) bags->append (dir.absoluteFilePath (names.at (i)));
+    }
+  else
+    {
+      bags->append (arg);
+    }
+}
+
+
+
+/*!
+    Build the list of BAGs to convert from the command line arguments and the optional list file (one name,
+    directory, or wildcard per line, blank lines and lines starting with # are ignored).  Returns NVFalse with
+    an error message if the list file can't be read or nothing matched.
+*/
+
+uint8_t expand_bag_inputs (QStringList *args, char *list_file, QStringList *bags, char *error)
+{
+  for (int32_t i = 0 ; i < args->size () ; i++) add_bag_input (args->at (i), bags);
+
+
+  if (list_file[0])
+    {
+      FILE *fp;
+      char line[1024];
+
+      if ((fp = fopen (list_file, "r")) == NULL)
+        {
+          sprintf (error, "Unable to open list file %s : %s", list_file, strerror (errno));
+          return (NVFalse);
+        }
+
+      while (fgets (line, sizeof (line), fp))
+        {
+          QString name = QString (line).trimmed ();
+
+          if (name.isEmpty () || name.startsWith ("#")) continue;
+
+          add_bag_input (name, bags);
+        }
+
+      fclose (fp);
+    }
+
+
+  if (bags->isEmpty ())
+    {
+      strcpy (error, "No BAG files found");
+      return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+//  Get the size of each BAG so we know how big the jobs are.  We only need the header so this is quick.
+
+static void size_job (BATCH_JOB *job, int32_t cores)
+{
+  bagHandle bag_handle;
+
+
+  if (bagFileOpen (&bag_handle, BAG_OPEN_READONLY, (u8 *) job->bag_file) == BAG_SUCCESS)
+    {
+      job->rows = bagGetDataPointer (bag_handle)->def.nrows;
+      job->cols = bagGetDataPointer (bag_handle)->def.ncols;
+      job->cells = (int64_t) job->rows * job->cols;
+
+      bagFileClose (bag_handle);
+    }
+  else
+    {
+      job->cells = QFileInfo (job->bag_file).size ();
+    }
+
+  job->want = (int32_t) qBound ((int64_t) 1, (job->cells + CELLS_PER_THREAD - 1) / CELLS_PER_THREAD, (int64_t) cores);
+}
+
+
+
+//  Biggest first (qsort).
+
+static int32_t compare_jobs (const void *a, const void *b)
+{
+  const BATCH_JOB *ja = *(const BATCH_JOB **) a, *jb = *(const BATCH_JOB **) b;
+
+  if (ja->cells > jb->cells) return (-1);
+  if (ja->cells < jb->cells) return (1);
+
+  return (0);
+}
+
+
+
+//  Print the per file summary to stderr and, if asked for, write it to a CSV file.
+
+static void write_summary (BATCH_JOB *jobs, int32_t count, JOB_OPTIONS *options)
+{
+  static const char *state_name[5] = {"PENDING", "RUNNING", "OK", "FAILED", "CURRENT"};
+  int32_t failed = 0, skipped = 0;
+  double total = 0.0;
+
+
+  fprintf (stderr, "\n%-8s %8s %8s %7s %10s %14s  %s\n", "Status", "Rows", "Columns", "Threads", "Seconds", "TIFF bytes",
+           "BAG file");
+
+  for (int32_t i = 0 ; i < count ; i++)
+    {
+      BATCH_JOB *job = &jobs[i];
+
+      fprintf (stderr, "%-8s %8d %8d %7d %10.1f %14lld  %s\n", state_name[job->state], job->rows, job->cols, job->threads,
+               job->seconds, (long long) job->output_bytes, job->bag_file);
+      if (job->state == JOB_SKIPPED)
+        {
+          skipped++;
+        }
+      else if (job->state != JOB_DONE)
+        {
+          fprintf (stderr, "         %s\n", job->message);
+          failed++;
+        }
+
+      total += job->seconds;
+    }
+
+  fprintf (stderr, "\n%d of %d files converted, %d already up to date, %d failed, %.1f job seconds\n\n",
+           count - failed - skipped, count, skipped, failed, total);
+  fflush (stderr);
+
+
+  if (options->summary_file[0])
+    {
+      FILE *fp;
+
+      if ((fp = fopen (options->summary_file, "w")) == NULL)
+        {
+          fprintf (stderr, "Unable to open summary file %s : %s\n", options->summary_file, strerror (errno));
+          return;
+        }
+
+      fprintf (fp, "bag_file,output_file,status,rows,columns,threads,seconds,output_bytes,message\n");
+
+      for (int32_t i = 0 ; i < count ; i++)
+        {
+          BATCH_JOB *job = &jobs[i];
+
+          fprintf (fp, "\"%s\",\"%s\",%s,%d,%d,%d,%.3f,%lld,\"%s\"\n", job->bag_file, job->output_file, state_name[job->state],
+                   job->rows, job->cols, job->threads, job->seconds, (long long) job->output_bytes, job->message);
+        }
+
+      fclose (fp);
+    }
+}
+
+
+
+//  Pick up the results of a finished child process.
+
+static void finish_job (BATCH_JOB *job, QProcess *proc, QElapsedTimer *timer)
+{
+  job->seconds = (double) timer->elapsed () / 1000.0;
+
+  QStringList lines = QString (proc->readAll ()).split ("\n");
+
+  if (proc->exitStatus () == QProcess::NormalExit && proc->exitCode () == 0)
+    {
+      job->state = JOB_DONE;
+      job->output_bytes = QFileInfo (job->output_file).size ();
+    }
+  else
+    {
+      job->state = JOB_FAILED;
+
+
+      //  The last thing the child said is the error.
+
+      strcpy (job->message, "Conversion failed");
+
+      for (int32_t i = lines.size () - 1 ; i >= 0 ; i--)
+        {
+          QString line = lines.at (i).trimmed ();
+
+          if (!line.isEmpty ())
+            {
+              strncpy (job->message, line.toLatin1 (), sizeof (job->message) - 1);
+              break;
+            }
+        }
+
+      if (proc->exitStatus () != QProcess::NormalExit) strcpy (job->message, "Conversion crashed");
+    }
+}
+
+
+
+/*!
+    Convert all of the BAGs in bags.  program is this program (argv[0]) and pass_args are the conversion options
+    to pass on to each child.  params are those options parsed (for the build cache).  Returns 0 if every BAG was
+    converted, otherwise -1.
+*/
+
+int32_t run_batch_jobs (char *program, QStringList *pass_args, CONVERT_PARAMS *params, QStringList *bags,
+                        JOB_OPTIONS *options)
+{
+  int32_t count = bags->size (), cores, max_jobs, free_cores, running = 0, done = 0, next = 0, pending = 0;
+  BATCH_JOB *jobs, **order;
+  QProcess **proc;
+  QElapsedTimer *timer;
+
+
+  cores = options->cores;
+  if (cores <= 0) cores = QThread::idealThreadCount ();
+  if (cores <= 0) cores = 1;
+
+  max_jobs = options->max_jobs;
+  if (max_jobs <= 0) max_jobs = cores;
+  max_jobs = qMin (max_jobs, count);
+
+  free_cores = cores;
+
+
+  jobs = (BATCH_JOB *) calloc (count, sizeof (BATCH_JOB));
+  order = (BATCH_JOB **) calloc (count, sizeof (BATCH_JOB *));
+  proc = (QProcess **) calloc (count, sizeof (QProcess *));
+  timer = new QElapsedTimer[count];
+
+  QString *keys = new QString[count];
+
+  if (jobs == NULL || order == NULL || proc == NULL)
+    {
+      fprintf (stderr, "Error allocating job memory : %s\n", strerror (errno));
+      free (jobs);
+      free (order);
+      free (proc);
+      delete[] timer;
+      delete[] keys;
+      return (-1);
+    }
+
+
+  //  Load the build cache if we're using one.  If it can't be read we just convert everything.
+
+  buildCache *cache = NULL;
+
+  if (options->cache_file[0])
+    {
+      cache = new buildCache (options->cache_file, params, options->cache_hash);
+
+      if (!cache->load ()) fprintf (stderr, "Unable to read build cache %s, converting everything\n", options->cache_file);
+    }
+
+
+  //  Each job gets its share of the memory limits.  Don't let a non-zero limit go to zero.
+
+  int32_t spill_memory = options->spill_memory / max_jobs;
+  if (options->spill_memory && !spill_memory) spill_memory = 1;
+
+  int32_t pipeline_memory = options->pipeline_memory / max_jobs;
+  if (options->pipeline_memory && !pipeline_memory) pipeline_memory = 1;
+
+  int32_t memory_budget = options->memory_budget / max_jobs;
+  if (options->memory_budget && !memory_budget) memory_budget = 1;
+
+
+  for (int32_t i = 0 ; i < count ; i++)
+    {
+      BATCH_JOB *job = &jobs[i];
+
+      strncpy (job->bag_file, bags->at (i).toLatin1 (), sizeof (job->bag_file) - 1);
+
+      if (options->output_dir[0])
+        {
+          QString name = QDir (options->output_dir).filePath (QFileInfo (bags->at (i)).fileName () + ".tif");
+          strncpy (job->output_file, name.toLatin1 (), sizeof (job->output_file) - 1);
+        }
+      else
+        {
+          snprintf (job->output_file, sizeof (job->output_file), "%s.tif", job->bag_file);
+        }
+
+      if (cache)
+        {
+          keys[i] = cache->key (job->bag_file, job->output_file);
+
+          if (cache->current (keys[i], job->output_file))
+            {
+              job->state = JOB_SKIPPED;
+              job->output_bytes = QFileInfo (job->output_file).size ();
+              done++;
+              continue;
+            }
+        }
+
+      size_job (job, cores);
+
+      order[pending++] = job;
+    }
+
+
+
+  //  Save the BAG hashes we just worked out so the next run doesn't have to read the BAGs again, even if nothing
+  //  gets converted this time.
+
+  if (cache && options->cache_hash && !cache->save ())
+    fprintf (stderr, "Unable to write build cache %s\n", options->cache_file);
+
+  qsort (order, pending, sizeof (BATCH_JOB *), compare_jobs);
+
+
+  if (!options->quiet)
+    {
+      fprintf (stderr, "\nConverting %d of %d BAG files using %d cores, at most %d at a time\n\n", pending, count, cores,
+               max_jobs);
+      fflush (stderr);
+    }
+
+
+  while (done < count)
+    {
+      //  Start as many jobs as we have cores for.
+
+      while (next < pending && free_cores > 0 && running < max_jobs)
+        {
+          BATCH_JOB *job = order[next];
+          int32_t j = job - jobs;
+
+          int32_t give = qMin (job->want, free_cores);
+
+          if (running && give < (job->want + 1) / 2) break;
+
+
+          QStringList args;
+
+          args << "--batch" << *pass_args << "--quiet" << QString ("--threads=%1").arg (give) <<
+            QString ("--spill_memory=%1").arg (spill_memory) << QString ("--pipeline_memory=%1").arg (pipeline_memory);
+
+          if (memory_budget) args << QString ("--memory=%1").arg (memory_budget);
+
+          args << QString (job->bag_file) << QString (job->output_file);
+
+          proc[j] = new QProcess;
+          proc[j]->setProcessChannelMode (QProcess::MergedChannels);
+          proc[j]->start (QString (program), args);
+
+          timer[j].start ();
+          next++;
+
+          if (!proc[j]->waitForStarted ())
+            {
+              job->state = JOB_FAILED;
+              strncpy (job->message, proc[j]->errorString ().toLatin1 (), sizeof (job->message) - 1);
+              delete proc[j];
+              proc[j] = NULL;
+              done++;
+              continue;
+            }
+
+          job->threads = give;
+          job->state = JOB_RUNNING;
+          free_cores -= give;
+          running++;
+        }
+
+
+      //  Wait for something to finish.
+
+      for (int32_t j = 0 ; j < count ; j++)
+        {
+          if (proc[j] == NULL) continue;
+
+          if (proc[j]->state () == QProcess::NotRunning || proc[j]->waitForFinished (20))
+            {
+              finish_job (&jobs[j], proc[j], &timer[j]);
+
+              delete proc[j];
+              proc[j] = NULL;
+
+              free_cores += jobs[j].threads;
+              running--;
+              done++;
+
+
+              //  Save the cache after every conversion so an interrupted run doesn't lose what it did.
+
+              if (cache && jobs[j].state == JOB_DONE)
+                {
+                  cache->update (keys[j], jobs[j].output_file);
+                  if (!cache->save ()) fprintf (stderr, "Unable to write build cache %s\n", options->cache_file);
+                }
+
+              if (!options->quiet)
+                {
+                  fprintf (stderr, "[%d/%d] %s %s (%.1f seconds)\n", done, count, jobs[j].state == JOB_DONE ? "Converted" : "FAILED",
+                           jobs[j].bag_file, jobs[j].seconds);
+                  fflush (stderr);
+                }
+            }
+        }
+    }
+
+
+  write_summary (jobs, count, options);
+
+
+  int32_t status = 0;
+  for (int32_t i = 0 ; i < count ; i++) if (jobs[i].state != JOB_DONE && jobs[i].state != JOB_SKIPPED) status = -1;
+
+  if (cache) delete cache;
+
+  free (jobs);
+  free (order);
+  free (proc);
+  delete[] timer;
+  delete[] keys;
+
+  return (status);
+}
@@ -0,0 +1,111 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include "bagGeotiffDef.hpp"
+#include "buildCache.hpp"
+
+
+/*!
+    Converts a whole delivery of BAGs at once from the command line (bagGeotiff --batch with more than one BAG,
+    a directory, a wildcard, or --list).  Each BAG is converted by a child bagGeotiff --batch process.  The HDF5
+    and BAG libraries aren't built thread safe so separate processes are the only safe way to have more than one
+    BAG open at a time.
+
+    The scheduler balances the cores between jobs and within jobs.  Each BAG asks for one render thread per
+    CELLS_PER_THREAD cells (at least one, at most all of the cores).  The biggest BAGs are started first and get
+    as many of the threads they asked for as are free.  Small BAGs get one thread each so lots of them run side
+    by side.  A big BAG that can't get at least half of what it asked for waits for more cores to come free
+    instead of starting on a sliver of the machine.  The spill and pipeline memory limits are split evenly between
+    the jobs that can run at the same time.
+
+    With a build cache (buildCache.cpp) BAGs whose GeoTIFFs are already up to date are skipped without even
+    being opened.
+*/
+
+#define         CELLS_PER_THREAD            16777216
+
+
+//  Job states.
+
+#define         JOB_PENDING                 0
+#define         JOB_RUNNING                 1
+#define         JOB_DONE                    2
+#define         JOB_FAILED                  3
+#define         JOB_SKIPPED                 4       //  Output already up to date (build cache)
+
+
+typedef struct
+{
+  int32_t       cores;                      //  Total threads to use across all jobs, 0 for one per core
+  int32_t       max_jobs;                   //  Most jobs to run at once, 0 for no limit other than the cores
+  int32_t       spill_memory;               //  Total row store memory in megabytes, split across the jobs
+  int32_t       pipeline_memory;            //  Total pipeline memory in megabytes, split across the jobs
+  int32_t       memory_budget;              //  Total memory budget in megabytes, split across the jobs, 0 for none
+  char          output_dir[1024];           //  Where to put the GeoTIFFs, empty to put them next to the BAGs
+  char          summary_file[1024];         //  CSV file for the per file summary, empty for none
+  char          cache_file[1024];           //  Build cache file, empty to always convert everything
+  uint8_t       cache_hash;                 //  Key the build cache on the MD5 of the BAG contents
+  uint8_t       quiet;
+} JOB_OPTIONS;
+
+
+typedef struct
+{
+  char          bag_file[1024];
+  char          output_file[1024];
+  int32_t       rows;                       //  BAG size, 0 if the BAG couldn't be opened
+  int32_t       cols;
+  int64_t       cells;                      //  rows * cols, or the file size if the BAG couldn't be opened
+  int32_t       want;                       //  Threads this job would like
+  int32_t       threads;                    //  Threads it got
+  int32_t       state;                      //  One of the JOB states above
+  double        seconds;
+  int64_t       output_bytes;
+  char          message[1024];              //  Error message from the child process if it failed
+} BATCH_JOB;
+
+
+uint8_t expand_bag_inputs (QStringList *args, char *list_file, QStringList *bags, char *error);
+int32_t run_batch_jobs (char *program, QStringList *pass_args, CONVERT_PARAMS *params, QStringList *bags,
+                        JOB_OPTIONS *options);
+
+
+#endif
@@ -55,6 +55,14 @@
 
 int main (int argc, char **argv)
 {
+    //  If we're running in batch mode we don't want to open a display at all.
+
+    for (int32_t i = 1 ; i < argc ; i++)
+    {
+        if (!strcmp (argv[i], "--batch")) return (batch_main (argc, argv));
+    }
+
+
     QApplication a (argc, argv);
 
 
@@ -0,0 +1,127 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#include "memoryPlan.hpp"
+
+#ifdef NVWIN3X
+#include <windows.h>
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+
+static const char *part_name[MEMORY_PARTS] = {"writer", "area_mask", "pipeline", "read_block", "chunk_cache", "gdal_cache",
+                                              "row_store"};
+
+
+//  Percent of the budget left after the fixed parts that each of the shared parts gets.  The row store gets
+//  whatever the others didn't use.
+
+static const int32_t part_percent[MEMORY_PARTS] = {0, 0, 40, 15, 5, 15, 0};
+
+
+
+const char *memory_part_name (int32_t part)
+{
+  return (part_name[part]);
+}
+
+
+
+/*!
+    Bytes that "part" of the plan may use.  The fixed parts (MEMORY_WRITER and MEMORY_MASK) must already be set
+    in the plan.  The share is bounded by minimum and maximum (0 for no maximum).  MEMORY_ROW_STORE gets whatever
+    the budget has left after all of the other parts in the plan, which may be 0.
+*/
+
+int64_t memory_share (MEMORY_PLAN *plan, int32_t part, int64_t minimum, int64_t maximum)
+{
+  int64_t share;
+
+
+  if (part == MEMORY_ROW_STORE)
+    {
+      share = plan->budget - memory_plan_total (plan) + plan->bytes[MEMORY_ROW_STORE];
+    }
+  else
+    {
+      share = (plan->budget - plan->bytes[MEMORY_WRITER] - plan->bytes[MEMORY_MASK]) * part_percent[part] / 100;
+    }
+
+  if (maximum && share > maximum) share = maximum;
+  if (share < minimum) share = minimum;
+
+  return (share);
+}
+
+
+
+//  Total bytes in the plan.
+
+int64_t memory_plan_total (MEMORY_PLAN *plan)
+{
+  int64_t total = 0;
+
+  for (int32_t i = 0 ; i < MEMORY_PARTS ; i++) total += plan->bytes[i];
+
+  return (total);
+}
+
+
+
+//  Peak resident set size of this process in kilobytes.
+
+int64_t peak_rss_kb ()
+{
+#ifdef NVWIN3X
+  PROCESS_MEMORY_COUNTERS pmc;
+
+  if (!GetProcessMemoryInfo (GetCurrentProcess (), &pmc, sizeof (pmc))) return (0);
+
+  return ((int64_t) pmc.PeakWorkingSetSize / 1024);
+#else
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage)) return (0);
+
+  return ((int64_t) usage.ru_maxrss);
+#endif
+}
@@ -0,0 +1,90 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#ifndef MEMORYPLAN_H
+#define MEMORYPLAN_H
+
+#include "bagGeotiffDef.hpp"
+
+
+/*!
+    Memory budget for bag_convert (bagGeotiff --batch --memory=MB).  When CONVERT_PARAMS.memory_budget is set,
+    every large buffer in the engine is sized out of that one number instead of from its own limit, so a BAG
+    much larger than RAM streams through in a fixed amount of memory.
+
+    The writer's tile row and overview buffers and the area mask span index have fixed sizes that depend only on
+    the window, so they come off the top.  What's left is shared out as follows:
+
+    - MEMORY_PIPELINE    40%, the row bands in flight in the read/render/write pipeline
+    - MEMORY_BLOCK       15%, the chunk aligned read block (at least one HDF5 chunk row)
+    - MEMORY_CHUNK_CACHE  5%, the HDF5 chunk cache of the BAG_READER (1 to 256 MB)
+    - MEMORY_GDAL_CACHE  15%, the GDAL block cache (GDAL_CACHEMAX), which also bounds the COG copy
+    - MEMORY_ROW_STORE   whatever is left, rows held in memory by the row store before it spills to disk
+
+    The plan records what was actually allocated (which can be a bit less than the share) along with the peak
+    resident set size of the process at the end of the run.
+*/
+
+
+#define         MEMORY_WRITER               0       //  TIFF_WRITER tile row and overview buffers
+#define         MEMORY_MASK                 1       //  Area mask span index
+#define         MEMORY_PIPELINE             2       //  Pipeline bands (elevations, fill flags, and pixels)
+#define         MEMORY_BLOCK                3       //  BAG_READER block
+#define         MEMORY_CHUNK_CACHE          4       //  HDF5 chunk cache
+#define         MEMORY_GDAL_CACHE           5       //  GDAL block cache
+#define         MEMORY_ROW_STORE            6       //  Row store memory (the rest is spilled)
+
+#define         MEMORY_PARTS                7
+
+
+typedef struct
+{
+  int64_t       budget;                     //  Bytes, 0 means no budget (each buffer uses its own limit)
+  int64_t       bytes[MEMORY_PARTS];        //  Bytes allocated (or allowed, for the caches) to each part
+  int64_t       peak_rss;                   //  Peak resident set size of the process in kilobytes
+} MEMORY_PLAN;
+
+
+const char *memory_part_name (int32_t part);
+int64_t memory_share (MEMORY_PLAN *plan, int32_t part, int64_t minimum, int64_t maximum);
+int64_t memory_plan_total (MEMORY_PLAN *plan);
+int64_t peak_rss_kb ();
+
+
+#endif
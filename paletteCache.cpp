@@ -0,0 +1,145 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#include "paletteCache.hpp"
+
+
+typedef struct
+{
+  float         key[4];                     //  Saturation, value, start hue, end hue (as palshd gets them)
+  int64_t       last_used;                  //  0 if the entry is empty
+  uint8_t       rgba[PALETTE_COLORS * 4];
+} PALETTE_ENTRY;
+
+
+static QMutex cache_mutex;
+static PALETTE_ENTRY preset_entry[SAMPLE_PRESETS], cache_entry[PALETTE_CACHE_SIZE];
+static uint8_t presets_built = NVFalse;
+static int64_t use_count = 0;
+
+
+
+//  The start and end hues are swapped going into palshd, the same way envin has always done it.
+
+static void build_entry (PALETTE_ENTRY *entry, float *key)
+{
+  memcpy (entry->key, key, sizeof (entry->key));
+
+  palshd (NUMSHADES, NUMHUES, key[3], key[2], key[0], key[0], key[1], 1.0, 0, NULL, entry->rgba);
+}
+
+
+
+static void build_presets ()
+{
+  for (int32_t i = 0 ; i < SAMPLE_PRESETS ; i++)
+    {
+      float key[4];
+
+      for (int32_t j = 0 ; j < 4 ; j++) key[j] = (float) sample_preset[i][j];
+
+      build_entry (&preset_entry[i], key);
+    }
+
+  presets_built = NVTrue;
+}
+
+
+
+//  Build the preset palettes.  Calling this isn't required (palette_get does it the first time through) but it
+//  keeps the cost out of the first redraw.
+
+void palette_cache_init ()
+{
+  QMutexLocker lock (&cache_mutex);
+
+  if (!presets_built) build_presets ();
+}
+
+
+
+/*!
+    Copy the palette for these colors into rgba (PALETTE_COLORS * 4 bytes), building it only if it isn't in the
+    cache.  The result is exactly what palshd would give.  It's copied out so that another thread can't throw it
+    out of the cache while it's being used.
+*/
+
+void palette_get (double saturation, double value, double start_hsv, double end_hsv, uint8_t *rgba)
+{
+  QMutexLocker lock (&cache_mutex);
+  float key[4] = {(float) saturation, (float) value, (float) start_hsv, (float) end_hsv};
+  PALETTE_ENTRY *entry;
+
+
+  if (!presets_built) build_presets ();
+
+  for (int32_t i = 0 ; i < SAMPLE_PRESETS ; i++)
+    {
+      if (!memcmp (preset_entry[i].key, key, sizeof (key)))
+        {
+          memcpy (rgba, preset_entry[i].rgba, sizeof (preset_entry[i].rgba));
+          return;
+        }
+    }
+
+
+  //  Look for it in the cache, keeping track of the least recently used (or an empty) entry in case it isn't there.
+
+  PALETTE_ENTRY *oldest = &cache_entry[0];
+
+  for (int32_t i = 0 ; i < PALETTE_CACHE_SIZE ; i++)
+    {
+      entry = &cache_entry[i];
+
+      if (entry->last_used && !memcmp (entry->key, key, sizeof (key)))
+        {
+          entry->last_used = ++use_count;
+          memcpy (rgba, entry->rgba, sizeof (entry->rgba));
+          return;
+        }
+
+      if (entry->last_used < oldest->last_used) oldest = entry;
+    }
+
+
+  build_entry (oldest, key);
+  oldest->last_used = ++use_count;
+
+  memcpy (rgba, oldest->rgba, sizeof (oldest->rgba));
+}
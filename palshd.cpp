@@ -38,18 +38,22 @@
 
 #include "bagGeotiffDef.hpp"
 
+/*!
+    Build the color array.  If rgba is not NULL it must point to num_shades * (num_hues + 1) * 4 bytes and it will
+    be filled with the same colors packed as R, G, B, A (alpha is always 255).  The renderer indexes the packed
+    table directly instead of calling the QColor accessors for every pixel.  Either color_array or rgba may be NULL
+    if you don't need it.
+*/
+
 void palshd (int num_shades, int num_hues, float start_hue, float end_hue, 
              float min_saturation, float max_saturation, float min_value, float max_value,
-             int start_color __attribute__ ((unused)), QColor color_array[])
+             int start_color __attribute__ ((unused)), QColor color_array[], uint8_t *rgba)
 {
   int                 half_length, color, i;
   float               saturation_increment, value_increment, hue_increment;
   float               hue, saturation, value, s;
 
 
-  void hsvrgb (float, float, float, QColor *);
-
-
 
   half_length = num_shades / 2;
   saturation_increment = (max_saturation - min_saturation) / half_length;
@@ -82,7 +86,13 @@ void palshd (int num_shades, int num_hues, float start_hue, float end_hue,
 
       for (s = 0.0 ; s < (float) num_shades ; s++)
         {
-          hsvrgb (hue, saturation, value, &color_array[color]);
+          if (color_array) hsvrgb (hue, saturation, value, &color_array[color]);
+
+          if (rgba)
+            {
+              hsvrgb (hue, saturation, value, &rgba[color * 4]);
+              rgba[color * 4 + 3] = 255;
+            }
 
 
           color++;
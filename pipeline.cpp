@@ -0,0 +1,123 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "pipeline.hpp"
+
+
+bandQueue::bandQueue ()
+{
+  head = count = 0;
+  closed = aborted = NVFalse;
+}
+
+
+
+//  There are only MAX_PIPELINE_BANDS bands so this can't overflow.
+
+void bandQueue::put (int32_t band)
+{
+  QMutexLocker lock (&mutex);
+
+  if (aborted) return;
+
+  this->band[(head + count) % MAX_PIPELINE_BANDS] = band;
+  count++;
+
+  ready.wakeOne ();
+}
+
+
+
+//  Returns the next band, or -1 if the queue is empty and has been closed (nothing more is coming).
+
+int32_t bandQueue::get ()
+{
+  QMutexLocker lock (&mutex);
+
+  while (!count && !closed) ready.wait (&mutex);
+
+  if (!count) return (-1);
+
+  int32_t next = band[head];
+  head = (head + 1) % MAX_PIPELINE_BANDS;
+  count--;
+
+  return (next);
+}
+
+
+
+//  No more bands will be put.  Anything still in the queue can still be got.
+
+void bandQueue::close ()
+{
+  QMutexLocker lock (&mutex);
+
+  closed = NVTrue;
+
+  ready.wakeAll ();
+}
+
+
+
+//  Close the queue and throw away anything in it.  Anything put after this is thrown away as well.
+
+void bandQueue::abort ()
+{
+  QMutexLocker lock (&mutex);
+
+  closed = aborted = NVTrue;
+  count = 0;
+
+  ready.wakeAll ();
+}
+
+
+
+stageThread::stageThread (PIPELINE_STAGE stage, void *user_data)
+{
+  this->stage = stage;
+  this->user_data = user_data;
+}
+
+
+
+void stageThread::run ()
+{
+  (*stage) (user_data);
+}
@@ -0,0 +1,116 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "bagGeotiffDef.hpp"
+
+
+/*!
+    Pieces for running the conversion as a three stage pipeline (read the BAG, render, write the GeoTIFF) with
+    each stage in its own thread.  The stages pass bands of rows to each other by index through bandQueues.  There
+    are a fixed number of bands so the queues can never hold more than that and the number of bands is the cap on
+    how much memory is in flight.  The empty bands go back to the reader through a queue as well, so a stage that
+    gets ahead just waits for the next band to come free.  To stop early, abort the empty queue.  The reader then
+    gets no more bands and the rest of the pipeline drains.
+*/
+
+#define         MAX_PIPELINE_BANDS          8
+
+
+//  One band of rows on its way through the pipeline.
+
+typedef struct
+{
+  float         *rows;                      //  num_rows + 1 elevation rows, the first one is the sunshade halo
+  uint8_t       *fill;                      //  num_rows * width fill flags
+  uint8_t       *pixels;                    //  num_rows * width * bands rendered, pixel interleaved output
+  int32_t       first_row;                  //  Output row of the first row in the band
+  int32_t       num_rows;
+} PIPELINE_BAND;
+
+
+//  Thread safe FIFO of band indices.  get blocks until there is a band or the queue has been closed.
+
+class bandQueue
+{
+public:
+
+  bandQueue ();
+
+  void put (int32_t band);
+  int32_t get ();
+  void close ();
+  void abort ();
+
+
+protected:
+
+  QMutex           mutex;
+
+  QWaitCondition   ready;
+
+  int32_t          band[MAX_PIPELINE_BANDS], head, count;
+
+  uint8_t          closed, aborted;
+};
+
+
+//  Runs a stage function in its own thread.
+
+typedef void (*PIPELINE_STAGE) (void *user_data);
+
+class stageThread : public QThread
+{
+public:
+
+  stageThread (PIPELINE_STAGE stage, void *user_data);
+
+
+protected:
+
+  void run ();
+
+  PIPELINE_STAGE   stage;
+
+  void             *user_data;
+};
+
+
+#endif
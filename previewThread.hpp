@@ -0,0 +1,83 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#ifndef PREVIEWTHREAD_H
+#define PREVIEWTHREAD_H
+
+#include "bagGeotiffDef.hpp"
+#include "bagPyramid.hpp"
+
+
+/*!
+    Builds the preview pyramid of a BAG (bagPyramid.cpp) in its own thread so that the image page stays usable
+    while the BAG is being read.  The status, pyramid, and error are valid once the QThread finished signal has
+    been sent.  Call cancel (and wait) before starting another build or opening the BAG anywhere else, the HDF5
+    library isn't thread safe.
+*/
+
+class previewThread : public QThread
+{
+  Q_OBJECT
+
+
+public:
+
+  previewThread (QObject *parent = 0);
+  ~previewThread ();
+
+  void build (char *bag_file);
+  void cancel ();
+
+  uint8_t          status;
+
+  BAG_PYRAMID      pyramid;
+
+  char             bag_file[1024];
+
+  char             error[2048];
+
+
+protected:
+
+  void run ();
+
+  QAtomicInt       canceled;
+};
+
+#endif
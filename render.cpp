@@ -0,0 +1,337 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "render.hpp"
+
+
+//  Colorize and sunshade columns start through end - 1 of a row.  This is the inner loop that used to be in
+//  bagGeotiff::slotCustomButtonClicked.  Don't change the arithmetic in here unless you want to change the output.
+
+static void render_span (RENDER_PARAMS *rp, float *next_row, float *current_row, int32_t start, int32_t end, float *shade,
+                         uint8_t *pixels)
+{
+  int32_t             c_index;
+  float               shade_factor;
+  STAGE_CLOCK         clock;
+
+
+  if (rp->shade_lut || rp->fast_shade)
+    {
+      if (rp->timing) stage_start (&clock);
+
+      if (rp->shade_lut)
+        {
+          shade_lut_span (rp->shade_lut, next_row, current_row, start, end, shade);
+        }
+      else
+        {
+          shade_span (next_row, current_row, start, end, &rp->sunopts, rp->x_cell_size, rp->y_cell_size, shade);
+        }
+
+      if (rp->timing) stage_stop (rp->timing, STAGE_SHADE, &clock, end - start);
+    }
+
+
+  if (rp->timing) stage_start (&clock);
+
+  for (int32_t j = start ; j < end ; j++)
+    {
+      if (current_row[j] != -NULL_ELEVATION)
+        {
+          float val = current_row[j];
+
+          if (rp->cross_zero)
+            {
+              if (val < 0.0)
+                {
+                  c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((val - rp->min_val) / rp->range[0] * NUMHUES))) * NUMSHADES;
+                }
+              else
+                {
+                  c_index = (int32_t) (NUMHUES - (int32_t) (fabsf (val) / rp->range[1] * NUMHUES)) * NUMSHADES;
+                }
+            }
+          else
+            {
+              c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((val - rp->min_val) / rp->range[0] * NUMHUES))) * NUMSHADES;
+            }
+        }
+      else
+        {
+          c_index = -2; 
+        }
+
+      if (rp->shade_lut || rp->fast_shade)
+        {
+          shade_factor = shade[j];
+        }
+      else
+        {
+          shade_factor = sunshade (next_row, current_row, j, &rp->sunopts, rp->x_cell_size, rp->y_cell_size);
+        }
+
+      if (shade_factor < 0.0) shade_factor = rp->sunopts.min_shade;
+
+      c_index -= NINT (NUMSHADES * shade_factor + 0.5);
+
+
+      uint8_t *pixel = &pixels[j * rp->bands];
+
+      if (c_index >= 0)
+        {
+          uint8_t *rgba = &rp->palette[c_index * 4];
+
+          for (int32_t b = 0 ; b < rp->bands ; b++) pixel[b] = rgba[b];
+        }
+      else
+        {
+          for (int32_t b = 0 ; b < rp->bands ; b++) pixel[b] = 0;
+        }
+    }
+
+  if (rp->timing) stage_stop (rp->timing, STAGE_COLOR, &clock, end - start);
+}
+
+
+
+//  Colorize and sunshade one row.  Only the runs of cells with fill set (the inside of the area polygon, see
+//  areaMask.cpp) are shaded and colored, everything else is cleared.  If rp->fast_shade or rp->shade_lut is set,
+//  shade must point to width floats of scratch space for shade_span or shade_lut_span.  pixels gets rp->width
+//  pixels of rp->bands bytes.
+
+void render_row (RENDER_PARAMS *rp, float *next_row, float *current_row, uint8_t *fill, float *shade, uint8_t *pixels)
+{
+  int32_t j = 0;
+
+  while (j < rp->width)
+    {
+      int32_t start = j;
+      while (j < rp->width && !fill[j]) j++;
+
+      if (j > start) memset (&pixels[start * rp->bands], 0, (j - start) * rp->bands);
+
+      start = j;
+      while (j < rp->width && fill[j]) j++;
+
+      if (j > start) render_span (rp, next_row, current_row, start, j, shade, pixels);
+    }
+}
+
+
+
+renderTask::renderTask (RENDER_PARAMS *rp, float *rows, uint8_t *fill, uint8_t *pixels, int32_t start_row, int32_t end_row)
+{
+  this->rp = rp;
+  this->rows = rows;
+  this->fill = fill;
+  this->pixels = pixels;
+  this->start_row = start_row;
+  this->end_row = end_row;
+}
+
+
+
+void renderTask::run ()
+{
+  int32_t width = rp->width;
+  float *shade = NULL;
+
+
+  //  If we can't get the scratch row we'll just have to do it the slow way.
+
+  RENDER_PARAMS params = *rp;
+
+
+  //  Keep our own times and add them in at the end so the render threads don't fight over them.
+
+  STAGE_TIMES times;
+
+  if (rp->timing)
+    {
+      memset (&times, 0, sizeof (STAGE_TIMES));
+      params.timing = &times;
+    }
+
+  if (params.shade_lut || params.fast_shade)
+    {
+      shade = (float *) malloc (width * sizeof (float));
+      if (shade == NULL)
+        {
+          params.shade_lut = NULL;
+          params.fast_shade = NVFalse;
+        }
+    }
+
+
+  int64_t checked = 0, mismatches = 0;
+
+  for (int32_t t = start_row ; t < end_row ; t++)
+    {
+      int64_t offset = (int64_t) t * width;
+      float *next_row = &rows[offset + width], *current_row = &rows[offset];
+
+      render_row (&params, next_row, current_row, &fill[offset], shade, &pixels[offset * rp->bands]);
+
+
+      //  Every SHADE_LUT_SAMPLE rows, compare the shade levels we got from the lookup table with what sunshade
+      //  would have given.  render_row left the table values in shade for every filled cell.
+
+      if (params.shade_lut && !(t % SHADE_LUT_SAMPLE))
+        {
+          for (int32_t j = 0 ; j < width ; j++)
+            {
+              if (fill[offset + j] && current_row[j] != -NULL_ELEVATION)
+                {
+                  float exact = sunshade (next_row, current_row, j, &params.sunopts, params.x_cell_size, params.y_cell_size);
+
+                  checked++;
+                  if (shade_index (shade[j], &params.sunopts) != shade_index (exact, &params.sunopts)) mismatches++;
+                }
+            }
+        }
+    }
+
+
+  free (shade);
+
+  if (checked) shade_lut_count (params.shade_lut, checked, mismatches);
+
+  if (rp->timing) stage_times_merge (rp->timing, &times);
+}
+
+
+
+/*!
+    Render num_rows rows of a band.  The band is split into one piece per pool thread and we wait for all of them
+    to finish so the caller can write the rows out in order.  Each row only depends on its own two elevation rows
+    so the output is identical no matter how many threads are used.  If pool is NULL the band is rendered in the
+    calling thread.
+*/
+
+void render_band (RENDER_PARAMS *rp, float *rows, int32_t num_rows, uint8_t *fill, uint8_t *pixels, QThreadPool *pool)
+{
+  int32_t pieces = 1;
+
+  if (pool) pieces = qMin (pool->maxThreadCount (), num_rows);
+
+
+  if (pieces <= 1)
+    {
+      renderTask task (rp, rows, fill, pixels, 0, num_rows);
+      task.run ();
+      return;
+    }
+
+
+  int32_t rows_per_piece = (num_rows + pieces - 1) / pieces;
+
+  for (int32_t start = 0 ; start < num_rows ; start += rows_per_piece)
+    {
+      renderTask *task = new renderTask (rp, rows, fill, pixels, start, qMin (start + rows_per_piece, num_rows));
+
+      task->setAutoDelete (true);
+      pool->start (task);
+    }
+
+  pool->waitForDone ();
+}
+
+
+
+/*!
+    Render a whole image in this thread for the image page previews.  rows holds height rows of rp->width depths,
+    northern row first (the way the preview pyramid and the sample data are stored).  Row k is shaded with rows
+    k - 1 and k, the same pairing bag_convert uses, so the preview looks like the GeoTIFF will.  Empty cells are
+    transparent.  If cancel is not NULL and gets set (from another thread) we stop at the next row.  Returns
+    NVFalse if the memory can't be allocated or the render was canceled.
+*/
+
+uint8_t render_image (RENDER_PARAMS *rp, float *rows, int32_t height, QImage *image, QAtomicInt *cancel)
+{
+  RENDER_PARAMS params = *rp;
+  float *shade = NULL;
+
+
+  params.bands = 4;
+  params.timing = NULL;
+
+  *image = QImage (params.width, height, QImage::Format_RGBA8888);
+
+  uint8_t *fill = (uint8_t *) malloc (params.width);
+
+  if (params.shade_lut || params.fast_shade)
+    {
+      shade = (float *) malloc (params.width * sizeof (float));
+      if (shade == NULL)
+        {
+          params.shade_lut = NULL;
+          params.fast_shade = NVFalse;
+        }
+    }
+
+  if (image->isNull () || fill == NULL)
+    {
+      free (fill);
+      free (shade);
+      return (NVFalse);
+    }
+
+  memset (fill, 1, params.width);
+
+
+  uint8_t status = NVTrue;
+
+  for (int32_t k = 0 ; k < height ; k++)
+    {
+      if (cancel && cancel->loadAcquire ())
+        {
+          status = NVFalse;
+          break;
+        }
+
+      float *current_row = &rows[(int64_t) qMax (k - 1, 0) * params.width];
+
+      render_row (&params, &rows[(int64_t) k * params.width], current_row, fill, shade, image->scanLine (k));
+    }
+
+
+  free (fill);
+  free (shade);
+
+  return (status);
+}
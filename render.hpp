@@ -0,0 +1,100 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "bagGeotiffDef.hpp"
+#include "shade.hpp"
+#include "stageTimer.hpp"
+
+
+/*!
+    The colorize and sunshade kernel.  Everything the per-pixel loop needs is in RENDER_PARAMS so that the same
+    kernel can be run from any thread.  Rows are rendered in bands.  A band of num_rows output rows needs
+    num_rows + 1 elevation rows (already flipped to depth) in output order.  Row t of the band is shaded using
+    elevation row t (the current row) and elevation row t + 1 (the next row).  The output is pixel interleaved
+    R, G, B (and A if bands is 4), ready to go straight to the GeoTIFF writer.
+*/
+
+typedef struct
+{
+  int32_t       width;
+  uint8_t       cross_zero;
+  float         min_val;
+  float         range[2];
+  double        x_cell_size;
+  double        y_cell_size;
+  SUN_OPT       sunopts;
+  uint8_t       fast_shade;                 //  Use shade_row (shade.cpp) instead of sunshade for every pixel
+  SHADE_LUT     *shade_lut;                 //  Look the shade factors up in this table (shade.hpp), NULL for none
+  uint8_t       *palette;                   //  Packed R, G, B, A palette built by palshd
+  int32_t       bands;                      //  3 (RGB) or 4 (RGBA) bytes per output pixel
+  STAGE_TIMES   *timing;                    //  Shade and colorize times (stageTimer.hpp), NULL for none
+} RENDER_PARAMS;
+
+
+//  Renders a subset of the rows of a band in a thread pool thread.
+
+class renderTask : public QRunnable
+{
+public:
+
+  renderTask (RENDER_PARAMS *rp, float *rows, uint8_t *fill, uint8_t *pixels, int32_t start_row, int32_t end_row);
+
+  void run ();
+
+
+protected:
+
+  RENDER_PARAMS    *rp;
+
+  float            *rows;
+
+  uint8_t          *fill, *pixels;
+
+  int32_t          start_row, end_row;
+};
+
+
+void render_row (RENDER_PARAMS *rp, float *next_row, float *current_row, uint8_t *fill, float *shade, uint8_t *pixels);
+void render_band (RENDER_PARAMS *rp, float *rows, int32_t num_rows, uint8_t *fill, uint8_t *pixels, QThreadPool *pool);
+uint8_t render_image (RENDER_PARAMS *rp, float *rows, int32_t height, QImage *image, QAtomicInt *cancel);
+
+
+#endif
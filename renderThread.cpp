@@ -0,0 +1,141 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#include "renderThread.hpp"
+
+
+renderThread::renderThread (QObject *parent)
+  : QThread (parent)
+{
+  memset (&pending, 0, sizeof (PREVIEW_JOB));
+  have_pending = NVFalse;
+  stopping = NVFalse;
+  generation = 0;
+}
+
+
+
+renderThread::~renderThread ()
+{
+  stop ();
+  wait ();
+
+  if (have_pending) free (pending.rows);
+}
+
+
+
+/*!
+    Queue a job, replacing any job that's waiting and canceling the one in progress.  The job (including the rows)
+    now belongs to us.  Returns the generation number of the job.  The thread is started the first time through.
+*/
+
+int32_t renderThread::render (PREVIEW_JOB *job)
+{
+  QMutexLocker lock (&mutex);
+
+
+  if (have_pending) free (pending.rows);
+
+  pending = *job;
+  have_pending = NVTrue;
+  generation++;
+
+  stale.storeRelease (1);
+  wake.wakeOne ();
+
+  if (!isRunning ()) start ();
+
+  return (generation);
+}
+
+
+
+//  Cancel whatever we're doing and end the thread.
+
+void renderThread::stop ()
+{
+  QMutexLocker lock (&mutex);
+
+  stopping = NVTrue;
+  stale.storeRelease (1);
+  wake.wakeOne ();
+}
+
+
+
+void renderThread::run ()
+{
+  while (NVTrue)
+    {
+      mutex.lock ();
+
+      while (!have_pending && !stopping) wake.wait (&mutex);
+
+      if (stopping)
+        {
+          mutex.unlock ();
+          break;
+        }
+
+      PREVIEW_JOB job = pending;
+      int32_t job_generation = generation;
+
+      have_pending = NVFalse;
+      stale.storeRelease (0);
+
+      mutex.unlock ();
+
+
+      QImage image;
+
+      job.rp.palette = job.palette;
+
+      uint8_t done = render_image (&job.rp, job.rows, job.height, &image, &stale);
+
+      free (job.rows);
+
+
+      //  Scaling is part of the job too, QImage (unlike QPixmap) is fine outside of the GUI thread.
+
+      if (done) image = image.scaled (job.box_width, job.box_height, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+      if (done && !stale.loadAcquire ()) emit rendered (image, job_generation);
+    }
+}
@@ -0,0 +1,106 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include "bagGeotiffDef.hpp"
+#include "render.hpp"
+#include "paletteCache.hpp"
+
+
+/*!
+    Renders the image page preview (render_image, render.cpp) in a background thread.  There is never more than
+    one job waiting.  A new job replaces the waiting one and cancels the one being rendered (it stops at the next
+    row), so when the parameters change faster than we can render only the latest set is ever finished.  Each job
+    gets a generation number and the finished image comes back with it through the (queued) rendered signal.  The
+    receiver should drop images whose generation isn't the last one it asked for.
+
+    Everything the render needs is copied into the job so the GUI thread can change the palette, or throw away
+    the preview pyramid, while we're working.
+*/
+
+typedef struct
+{
+  RENDER_PARAMS rp;                         //  rp.palette is ignored, palette is used
+  uint8_t       palette[PALETTE_COLORS * 4];
+  float         *rows;                      //  rp.width * height depths, northern row first (malloc'ed, owned by the job)
+  int32_t       height;
+  int32_t       box_width;                  //  Scale the image to fit in this box (keeping its shape)
+  int32_t       box_height;
+} PREVIEW_JOB;
+
+
+class renderThread : public QThread
+{
+  Q_OBJECT
+
+
+public:
+
+  renderThread (QObject *parent = 0);
+  ~renderThread ();
+
+  int32_t render (PREVIEW_JOB *job);
+  void stop ();
+
+
+signals:
+
+  void rendered (QImage image, int generation);
+
+
+protected:
+
+  void run ();
+
+  QMutex           mutex;
+
+  QWaitCondition   wake;
+
+  PREVIEW_JOB      pending;
+
+  uint8_t          have_pending, stopping;
+
+  int32_t          generation;
+
+  QAtomicInt       stale;
+};
+
+#endif
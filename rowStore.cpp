@@ -0,0 +1,143 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "rowStore.hpp"
+
+
+#ifdef NVWIN3X
+#define store_seek(a, b, c) _fseeki64 (a, b, c)
+#else
+#define store_seek(a, b, c) fseeko (a, (off_t) (b), c)
+#endif
+
+
+/*!
+    Open a row store for height rows of width floats.  memory_limit is the maximum number of bytes to hold in
+    memory.  Returns NVFalse (with errno set to EINVAL) if width or height is not positive, or if the memory or
+    the temporary file could not be allocated.
+*/
+
+uint8_t row_store_open (ROW_STORE *store, int32_t width, int32_t height, int64_t memory_limit)
+{
+  int64_t row_bytes = (int64_t) width * sizeof (float);
+
+
+  memset (store, 0, sizeof (ROW_STORE));
+
+  if (width <= 0 || height <= 0)
+    {
+      errno = EINVAL;
+      return (NVFalse);
+    }
+
+  store->width = width;
+  store->height = height;
+
+  store->mem_rows = (int32_t) qMin ((int64_t) height, memory_limit / row_bytes);
+
+  if (store->mem_rows)
+    {
+      store->memory = (float *) malloc (store->mem_rows * row_bytes);
+
+      if (store->memory == NULL) return (NVFalse);
+    }
+
+
+  if (store->mem_rows < height)
+    {
+      store->spill = tmpfile ();
+
+      if (store->spill == NULL)
+        {
+          free (store->memory);
+          store->memory = NULL;
+          return (NVFalse);
+        }
+    }
+
+  return (NVTrue);
+}
+
+
+
+//  Rows must be put in ascending order.
+
+uint8_t row_store_put (ROW_STORE *store, int32_t row, float *data)
+{
+  if (row < store->mem_rows)
+    {
+      memcpy (&store->memory[(int64_t) row * store->width], data, store->width * sizeof (float));
+      return (NVTrue);
+    }
+
+  if (fwrite (data, sizeof (float), store->width, store->spill) != (size_t) store->width) return (NVFalse);
+
+  store->spill_bytes += store->width * sizeof (float);
+
+  return (NVTrue);
+}
+
+
+
+//  Rows can be read back in any order.
+
+uint8_t row_store_get (ROW_STORE *store, int32_t row, float *data)
+{
+  if (row < store->mem_rows)
+    {
+      memcpy (data, &store->memory[(int64_t) row * store->width], store->width * sizeof (float));
+      return (NVTrue);
+    }
+
+  if (store_seek (store->spill, (int64_t) (row - store->mem_rows) * store->width * sizeof (float), SEEK_SET)) return (NVFalse);
+
+  if (fread (data, sizeof (float), store->width, store->spill) != (size_t) store->width) return (NVFalse);
+
+  return (NVTrue);
+}
+
+
+
+void row_store_close (ROW_STORE *store)
+{
+  if (store->memory) free (store->memory);
+  if (store->spill) fclose (store->spill);
+
+  store->memory = NULL;
+  store->spill = NULL;
+}
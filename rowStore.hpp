@@ -0,0 +1,69 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef ROWSTORE_H
+#define ROWSTORE_H
+
+#include "bagGeotiffDef.hpp"
+
+
+/*!
+    Bounded memory store for the decoded elevation rows of the output area.  The min/max pass puts each row in
+    the store as it reads it from the BAG and the render pass gets them back out so that the BAG (HDF5) data is
+    only decompressed once.  Rows are kept in memory up to the memory limit and the rest are spilled to an
+    unnamed temporary file that goes away when it is closed.
+*/
+
+typedef struct
+{
+  int32_t       width;
+  int32_t       height;
+  int32_t       mem_rows;                   //  Number of rows (starting at 0) that are held in memory
+  float         *memory;
+  FILE          *spill;                     //  Rows mem_rows through height - 1, NULL if everything fit
+  int64_t       spill_bytes;                //  Number of bytes written to the spill file
+} ROW_STORE;
+
+
+uint8_t row_store_open (ROW_STORE *store, int32_t width, int32_t height, int64_t memory_limit);
+uint8_t row_store_put (ROW_STORE *store, int32_t row, float *data);
+uint8_t row_store_get (ROW_STORE *store, int32_t row, float *data);
+void row_store_close (ROW_STORE *store);
+
+
+#endif
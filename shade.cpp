@@ -0,0 +1,488 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "shade.hpp"
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>
+#define SHADE_X86
+#endif
+
+
+static int32_t level = -1;
+
+
+
+//  Per row constants.  Everything is single precision so that the scalar and vector versions match exactly.
+
+typedef struct
+{
+  float         x_scale;                    //  exag / x_cell_size
+  float         y_scale;                    //  exag / y_cell_size
+  float         sun_x;
+  float         sun_y;
+  float         sun_z;
+} SHADE_CONSTANTS;
+
+
+
+/*!
+    Shade columns start through end - 1.  For each column:
+
+        dz/dx = (upper[c] - upper[c - 1]) * exag / x_cell_size      (0 in column 0)
+        dz/dy = (upper[c] - lower[c]) * exag / y_cell_size
+        shade = (-dz/dx, -dz/dy, 1) . sun / |(-dz/dx, -dz/dy, 1)|
+
+    If you change the order of the operations here you have to change it in the vector versions too.
+*/
+
+static void shade_scalar (float *lower_row, float *upper_row, int32_t start, int32_t end, SHADE_CONSTANTS *sc, float *shade)
+{
+  for (int32_t c = start ; c < end ; c++)
+    {
+      float dzdx = 0.0;
+      if (c) dzdx = (upper_row[c] - upper_row[c - 1]) * sc->x_scale;
+
+      float dzdy = (upper_row[c] - lower_row[c]) * sc->y_scale;
+
+      float len2 = dzdx * dzdx + dzdy * dzdy;
+      len2 = len2 + 1.0f;
+
+      float dot = sc->sun_z - sc->sun_x * dzdx;
+      dot = dot - sc->sun_y * dzdy;
+
+      shade[c] = dot / sqrtf (len2);
+    }
+}
+
+
+
+#ifdef SHADE_X86
+
+static void shade_sse (float *lower_row, float *upper_row, int32_t start, int32_t end, SHADE_CONSTANTS *sc, float *shade)
+{
+  __m128 x_scale = _mm_set1_ps (sc->x_scale);
+  __m128 y_scale = _mm_set1_ps (sc->y_scale);
+  __m128 sun_x = _mm_set1_ps (sc->sun_x);
+  __m128 sun_y = _mm_set1_ps (sc->sun_y);
+  __m128 sun_z = _mm_set1_ps (sc->sun_z);
+  __m128 one = _mm_set1_ps (1.0f);
+
+  int32_t c = start;
+
+  for ( ; c + 4 <= end ; c += 4)
+    {
+      __m128 up = _mm_loadu_ps (&upper_row[c]);
+      __m128 up_left = _mm_loadu_ps (&upper_row[c - 1]);
+      __m128 low = _mm_loadu_ps (&lower_row[c]);
+
+      __m128 dzdx = _mm_mul_ps (_mm_sub_ps (up, up_left), x_scale);
+      __m128 dzdy = _mm_mul_ps (_mm_sub_ps (up, low), y_scale);
+
+      __m128 len2 = _mm_add_ps (_mm_mul_ps (dzdx, dzdx), _mm_mul_ps (dzdy, dzdy));
+      len2 = _mm_add_ps (len2, one);
+
+      __m128 dot = _mm_sub_ps (sun_z, _mm_mul_ps (sun_x, dzdx));
+      dot = _mm_sub_ps (dot, _mm_mul_ps (sun_y, dzdy));
+
+      _mm_storeu_ps (&shade[c], _mm_div_ps (dot, _mm_sqrt_ps (len2)));
+    }
+
+  shade_scalar (lower_row, upper_row, c, end, sc, shade);
+}
+
+
+
+__attribute__ ((target ("avx2")))
+static void shade_avx2 (float *lower_row, float *upper_row, int32_t start, int32_t end, SHADE_CONSTANTS *sc, float *shade)
+{
+  __m256 x_scale = _mm256_set1_ps (sc->x_scale);
+  __m256 y_scale = _mm256_set1_ps (sc->y_scale);
+  __m256 sun_x = _mm256_set1_ps (sc->sun_x);
+  __m256 sun_y = _mm256_set1_ps (sc->sun_y);
+  __m256 sun_z = _mm256_set1_ps (sc->sun_z);
+  __m256 one = _mm256_set1_ps (1.0f);
+
+  int32_t c = start;
+
+  for ( ; c + 8 <= end ; c += 8)
+    {
+      __m256 up = _mm256_loadu_ps (&upper_row[c]);
+      __m256 up_left = _mm256_loadu_ps (&upper_row[c - 1]);
+      __m256 low = _mm256_loadu_ps (&lower_row[c]);
+
+      __m256 dzdx = _mm256_mul_ps (_mm256_sub_ps (up, up_left), x_scale);
+      __m256 dzdy = _mm256_mul_ps (_mm256_sub_ps (up, low), y_scale);
+
+      __m256 len2 = _mm256_add_ps (_mm256_mul_ps (dzdx, dzdx), _mm256_mul_ps (dzdy, dzdy));
+      len2 = _mm256_add_ps (len2, one);
+
+      __m256 dot = _mm256_sub_ps (sun_z, _mm256_mul_ps (sun_x, dzdx));
+      dot = _mm256_sub_ps (dot, _mm256_mul_ps (sun_y, dzdy));
+
+      _mm256_storeu_ps (&shade[c], _mm256_div_ps (dot, _mm256_sqrt_ps (len2)));
+    }
+
+  shade_scalar (lower_row, upper_row, c, end, sc, shade);
+}
+
+#endif
+
+
+
+//  Figure out the best instruction set we can use (once).
+
+int32_t shade_row_level ()
+{
+  if (level < 0)
+    {
+#ifdef SHADE_X86
+      __builtin_cpu_init ();
+
+      if (__builtin_cpu_supports ("avx2"))
+        {
+          level = SHADE_AVX2;
+        }
+      else if (__builtin_cpu_supports ("sse2"))
+        {
+          level = SHADE_SSE;
+        }
+      else
+        {
+          level = SHADE_SCALAR;
+        }
+#else
+      level = SHADE_SCALAR;
+#endif
+    }
+
+  return (level);
+}
+
+
+
+//  Force a lower instruction set level (mostly for checking that they all give the same answer).
+
+void shade_row_set_level (int32_t new_level)
+{
+  level = qMin (new_level, shade_row_level ());
+}
+
+
+
+/*!
+    Shade a whole row.  lower_row and upper_row are the same rows that you would pass to sunshade and shade[c] will
+    be what sunshade would return for column c.  power_cos other than 1.0 is applied after the fact in scalar code.
+*/
+
+void shade_row (float *lower_row, float *upper_row, int32_t width, SUN_OPT *sunopts, double x_cell_size, double y_cell_size,
+                float *shade)
+{
+  shade_span (lower_row, upper_row, 0, width, sunopts, x_cell_size, y_cell_size, shade);
+}
+
+
+
+/*!
+    Shade columns start through end - 1 of a row (the inside of an area polygon, for instance).  The results are
+    exactly what shade_row gives for those columns since column start still looks at column start - 1.
+*/
+
+void shade_span (float *lower_row, float *upper_row, int32_t start, int32_t end, SUN_OPT *sunopts, double x_cell_size,
+                 double y_cell_size, float *shade)
+{
+  SHADE_CONSTANTS sc;
+
+
+  if (end <= start) return;
+
+  sc.x_scale = (float) (sunopts->exag / x_cell_size);
+  sc.y_scale = (float) (sunopts->exag / y_cell_size);
+  sc.sun_x = (float) sunopts->sun.x;
+  sc.sun_y = (float) sunopts->sun.y;
+  sc.sun_z = (float) sunopts->sun.z;
+
+
+  //  Column 0 has no left neighbor so it's always done in scalar code.
+
+  int32_t vector_start = start;
+
+  if (!start)
+    {
+      shade_scalar (lower_row, upper_row, 0, 1, &sc, shade);
+      vector_start = 1;
+    }
+
+  switch (shade_row_level ())
+    {
+#ifdef SHADE_X86
+    case SHADE_AVX2:
+      shade_avx2 (lower_row, upper_row, vector_start, end, &sc, shade);
+      break;
+
+    case SHADE_SSE:
+      shade_sse (lower_row, upper_row, vector_start, end, &sc, shade);
+      break;
+#endif
+
+    default:
+      shade_scalar (lower_row, upper_row, vector_start, end, &sc, shade);
+      break;
+    }
+
+
+  if (sunopts->power_cos != 1.0)
+    {
+      for (int32_t c = start ; c < end ; c++)
+        {
+          if (shade[c] > 0.0) shade[c] = (float) pow ((double) shade[c], sunopts->power_cos);
+        }
+    }
+}
+
+
+
+/*!
+    Compare shade_row against sunshade over a synthetic patch of terrain (rolling hills with a few steep steps and
+    a couple of null cells) using the given sun options and cell sizes.  Returns NVTrue if the largest difference
+    is within SHADE_TOLERANCE.  The largest difference is returned in max_diff.
+*/
+
+uint8_t shade_row_check (SUN_OPT *sunopts, double x_cell_size, double y_cell_size, float *max_diff)
+{
+  const int32_t       width = 67, height = 24;
+  float               rows[height][width], shade[width];
+
+
+  //  The amplitude is scaled to the cell size so that we get a good spread of slopes no matter what the cell size is.
+
+  double amplitude = qMax (x_cell_size, y_cell_size) * 2.0;
+
+  for (int32_t i = 0 ; i < height ; i++)
+    {
+      for (int32_t j = 0 ; j < width ; j++)
+        {
+          rows[i][j] = (float) (amplitude * (sin (j * 0.37) * cos (i * 0.23) + 0.5 * sin ((i + j) * 1.3)));
+
+          if (j % 13 == 0 && i % 5 == 0) rows[i][j] += (float) (amplitude * 3.0);
+        }
+    }
+
+  rows[7][20] = -NULL_ELEVATION;
+  rows[15][40] = -NULL_ELEVATION;
+
+
+  *max_diff = 0.0;
+
+  for (int32_t i = 1 ; i < height ; i++)
+    {
+      shade_row (rows[i], rows[i - 1], width, sunopts, x_cell_size, y_cell_size, shade);
+
+      for (int32_t j = 0 ; j < width ; j++)
+        {
+          float diff = fabsf (shade[j] - sunshade (rows[i], rows[i - 1], j, sunopts, x_cell_size, y_cell_size));
+
+          if (!(diff <= *max_diff)) *max_diff = diff;
+        }
+    }
+
+  return (*max_diff <= SHADE_TOLERANCE);
+}
+
+
+
+//  The shade level that the renderer subtracts from the color index for this shade factor.  This is the same
+//  arithmetic as render_span (render.cpp), it's only here so the lookup table checks agree with it.
+
+int32_t shade_index (float shade_factor, SUN_OPT *sunopts)
+{
+  if (shade_factor < 0.0) shade_factor = sunopts->min_shade;
+
+  return (NINT (NUMSHADES * shade_factor + 0.5));
+}
+
+
+
+//  Where gradient g falls in the lookup table.  Returns the bin and sets frac to how far across the bin it is.
+
+static inline int32_t lut_bin (float g, float *frac)
+{
+  float u = (g / (1.0f + fabsf (g)) + 1.0f) * (0.5f * (float) SHADE_LUT_SIZE);
+
+  if (!(u > 0.0f)) u = 0.0f;
+
+  int32_t bin = qMin ((int32_t) u, SHADE_LUT_SIZE - 1);
+
+  *frac = u - (float) bin;
+
+  return (bin);
+}
+
+
+
+//  Inverse of the mapping in lut_bin for table node n.  The end nodes stand for infinite gradients.
+
+static double lut_gradient (int32_t n)
+{
+  double u = -1.0 + 2.0 * (double) n / (double) SHADE_LUT_SIZE;
+
+  if (u <= -1.0) return (-1.0e9);
+  if (u >= 1.0) return (1.0e9);
+
+  return (u / (1.0 - fabs (u)));
+}
+
+
+
+/*!
+    Build the lookup table for these sun options and cell sizes.  The table holds exactly what sunshade would
+    return (power_cos included) at each node.  This also clears the mismatch counts.
+*/
+
+void shade_lut_build (SHADE_LUT *lut, SUN_OPT *sunopts, double x_cell_size, double y_cell_size)
+{
+  lut->x_scale = (float) (sunopts->exag / x_cell_size);
+  lut->y_scale = (float) (sunopts->exag / y_cell_size);
+  lut->checked = lut->mismatches = 0;
+
+  for (int32_t i = 0 ; i <= SHADE_LUT_SIZE ; i++)
+    {
+      double dzdy = lut_gradient (i);
+
+      for (int32_t j = 0 ; j <= SHADE_LUT_SIZE ; j++)
+        {
+          double dzdx = lut_gradient (j);
+
+          double shade = (sunopts->sun.z - sunopts->sun.x * dzdx - sunopts->sun.y * dzdy) / sqrt (dzdx * dzdx + dzdy * dzdy + 1.0);
+
+          if (sunopts->power_cos != 1.0 && shade > 0.0) shade = pow (shade, sunopts->power_cos);
+
+          lut->table[i * (SHADE_LUT_SIZE + 1) + j] = (float) shade;
+        }
+    }
+}
+
+
+
+//  Same as shade_span but looked up in the table.  The gradients are figured exactly the way shade_scalar does.
+
+void shade_lut_span (SHADE_LUT *lut, float *lower_row, float *upper_row, int32_t start, int32_t end, float *shade)
+{
+  for (int32_t c = start ; c < end ; c++)
+    {
+      float dzdx = 0.0, fx, fy;
+      if (c) dzdx = (upper_row[c] - upper_row[c - 1]) * lut->x_scale;
+
+      float dzdy = (upper_row[c] - lower_row[c]) * lut->y_scale;
+
+      int32_t j = lut_bin (dzdx, &fx);
+      int32_t i = lut_bin (dzdy, &fy);
+
+      float *node = &lut->table[i * (SHADE_LUT_SIZE + 1) + j];
+
+      float top = node[0] + (node[1] - node[0]) * fx;
+      float bottom = node[SHADE_LUT_SIZE + 1] + (node[SHADE_LUT_SIZE + 2] - node[SHADE_LUT_SIZE + 1]) * fx;
+
+      shade[c] = top + (bottom - top) * fy;
+    }
+}
+
+
+
+//  Add the render threads' mismatch counts.
+
+static QMutex lut_mutex;
+
+void shade_lut_count (SHADE_LUT *lut, int64_t checked, int64_t mismatches)
+{
+  QMutexLocker lock (&lut_mutex);
+
+  lut->checked += checked;
+  lut->mismatches += mismatches;
+}
+
+
+
+/*!
+    Fraction of the cells of a synthetic patch of terrain (the same kind of hills and steps as shade_row_check,
+    but bigger) where the lookup table picks a different shade level than sunshade.  Returns -1.0 if the table
+    can't be allocated.
+*/
+
+double shade_lut_check (SUN_OPT *sunopts, double x_cell_size, double y_cell_size)
+{
+  const int32_t       width = 509, height = 256;
+  float               rows[2][width], shade[width];
+  int64_t             checked = 0, mismatches = 0;
+
+
+  SHADE_LUT *lut = (SHADE_LUT *) malloc (sizeof (SHADE_LUT));
+  if (lut == NULL) return (-1.0);
+
+  shade_lut_build (lut, sunopts, x_cell_size, y_cell_size);
+
+  double amplitude = qMax (x_cell_size, y_cell_size) * 2.0;
+
+  for (int32_t i = 0 ; i < height ; i++)
+    {
+      float *row = rows[i % 2], *above = rows[(i + 1) % 2];
+
+      for (int32_t j = 0 ; j < width ; j++)
+        {
+          row[j] = (float) (amplitude * (sin (j * 0.037) * cos (i * 0.023) + 0.5 * sin ((i + j) * 0.13)));
+
+          if (j % 13 == 0 && i % 5 == 0) row[j] += (float) (amplitude * 3.0);
+          if (j % 101 == 7 && i % 17 == 3) row[j] = -NULL_ELEVATION;
+        }
+
+      if (!i) continue;
+
+      shade_lut_span (lut, row, above, 0, width, shade);
+
+      for (int32_t j = 0 ; j < width ; j++)
+        {
+          checked++;
+          if (shade_index (shade[j], sunopts) != shade_index (sunshade (row, above, j, sunopts, x_cell_size, y_cell_size), sunopts))
+            mismatches++;
+        }
+    }
+
+  free (lut);
+
+  return ((double) mismatches / (double) checked);
+}
@@ -0,0 +1,108 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef SHADE_H
+#define SHADE_H
+
+#include "bagGeotiffDef.hpp"
+
+
+/*!
+    Row at a time hillshade kernel.  This computes the same thing as calling sunshade (nvutility) for every column
+    of a row, but the sun vector and cell size setup is only done once per row and the columns are done four (SSE)
+    or eight (AVX2) at a time.  There is always a scalar version that does the same float arithmetic in the same
+    order so the results don't depend on which instruction set was used.
+
+    Since the whole point is that this has to match sunshade, shade_row_check compares the two over a synthetic
+    patch of terrain for a given set of sun options.  The engine only uses shade_row if the check passes, otherwise
+    it falls back to calling sunshade for every pixel.
+*/
+
+
+//  Largest difference between shade_row and sunshade that we'll accept.
+
+#define         SHADE_TOLERANCE             0.0001
+
+
+//  Instruction set used by shade_row.
+
+#define         SHADE_SCALAR                0
+#define         SHADE_SSE                   1
+#define         SHADE_AVX2                  2
+
+
+/*!
+    Gradient lookup table (bagGeotiff --batch --lut_shade).  The shade only depends on the gradient pair
+    (dz/dx, dz/dy) once the sun options and cell sizes are fixed, and the renderer only uses it to pick one of
+    NUMSHADES shade levels.  So we build a table of the shade over the gradient plane once per run and look the
+    gradients up instead of normalizing and dotting a vector for every cell.  Each gradient g is mapped to
+    g / (1 + |g|) so that the whole plane (including the huge gradients next to empty cells) fits in
+    SHADE_LUT_SIZE bins per axis, and the shade is bilinearly interpolated between the table nodes.  That picks
+    the same shade level as sunshade for all but about a tenth of a percent of cells.  The renderer counts
+    the mismatches on a sample of the rows (every SHADE_LUT_SAMPLE rows) so the rate can be reported.
+*/
+
+#define         SHADE_LUT_SIZE              256
+#define         SHADE_LUT_SAMPLE            16
+
+
+typedef struct
+{
+  float         x_scale;                    //  exag / x_cell_size
+  float         y_scale;                    //  exag / y_cell_size
+  float         table[(SHADE_LUT_SIZE + 1) * (SHADE_LUT_SIZE + 1)];     //  Row is dz/dy, column is dz/dx
+  int64_t       checked;                    //  Cells compared against the exact shade
+  int64_t       mismatches;                 //  Cells where the shade level was different
+} SHADE_LUT;
+
+
+void shade_row (float *lower_row, float *upper_row, int32_t width, SUN_OPT *sunopts, double x_cell_size, double y_cell_size,
+                float *shade);
+void shade_span (float *lower_row, float *upper_row, int32_t start, int32_t end, SUN_OPT *sunopts, double x_cell_size,
+                 double y_cell_size, float *shade);
+int32_t shade_row_level ();
+void shade_row_set_level (int32_t level);
+uint8_t shade_row_check (SUN_OPT *sunopts, double x_cell_size, double y_cell_size, float *max_diff);
+int32_t shade_index (float shade_factor, SUN_OPT *sunopts);
+void shade_lut_build (SHADE_LUT *lut, SUN_OPT *sunopts, double x_cell_size, double y_cell_size);
+void shade_lut_span (SHADE_LUT *lut, float *lower_row, float *upper_row, int32_t start, int32_t end, float *shade);
+void shade_lut_count (SHADE_LUT *lut, int64_t checked, int64_t mismatches);
+double shade_lut_check (SUN_OPT *sunopts, double x_cell_size, double y_cell_size);
+
+
+#endif
@@ -0,0 +1,250 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "stageTimer.hpp"
+
+#ifdef NVWIN3X
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+static const char *stage_name[STAGE_COUNT] = {"open", "minmax", "read", "shade", "colorize", "write", "close"};
+
+static QMutex merge_mutex;
+
+
+
+static QElapsedTimer *start_wall_timer ()
+{
+  QElapsedTimer *timer = new QElapsedTimer;
+
+  timer->start ();
+
+  return (timer);
+}
+
+
+
+//  Monotonic nanoseconds.  The static is initialized once, thread safely, on the first call.
+
+static int64_t wall_now ()
+{
+  static QElapsedTimer *timer = start_wall_timer ();
+
+  return (timer->nsecsElapsed ());
+}
+
+
+
+//  CPU time of the calling thread (or the whole process).
+
+static int64_t cpu_now (uint8_t process)
+{
+#ifdef NVWIN3X
+  FILETIME creation, exit, kernel, user;
+
+  if (process)
+    {
+      GetProcessTimes (GetCurrentProcess (), &creation, &exit, &kernel, &user);
+    }
+  else
+    {
+      GetThreadTimes (GetCurrentThread (), &creation, &exit, &kernel, &user);
+    }
+
+  int64_t k = ((int64_t) kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+  int64_t u = ((int64_t) user.dwHighDateTime << 32) | user.dwLowDateTime;
+
+  return ((k + u) * 100);
+#else
+  struct timespec ts;
+
+  clock_gettime (process ? CLOCK_PROCESS_CPUTIME_ID : CLOCK_THREAD_CPUTIME_ID, &ts);
+
+  return ((int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec);
+#endif
+}
+
+
+
+void stage_start (STAGE_CLOCK *clock)
+{
+  clock->wall = wall_now ();
+  clock->cpu = cpu_now (NVFalse);
+}
+
+
+
+//  Add the time since stage_start (in the same thread) to a stage.
+
+void stage_stop (STAGE_TIMES *times, int32_t stage, STAGE_CLOCK *clock, int64_t cells)
+{
+  times->wall_ns[stage] += wall_now () - clock->wall;
+  times->cpu_ns[stage] += cpu_now (NVFalse) - clock->cpu;
+  times->calls[stage]++;
+  times->cells[stage] += cells;
+}
+
+
+
+//  Clear the times and start the clock for the whole run.
+
+void stage_times_start (STAGE_TIMES *times, STAGE_CLOCK *clock)
+{
+  memset (times, 0, sizeof (STAGE_TIMES));
+
+  clock->wall = wall_now ();
+  clock->cpu = cpu_now (NVTrue);
+}
+
+
+
+void stage_times_stop (STAGE_TIMES *times, STAGE_CLOCK *clock)
+{
+  times->total_wall_ns = wall_now () - clock->wall;
+  times->total_cpu_ns = cpu_now (NVTrue) - clock->cpu;
+}
+
+
+
+//  Add the stage times from a render task.  This is the only place where more than one thread adds to the same
+//  stages so it's the only place that needs locking.
+
+void stage_times_merge (STAGE_TIMES *times, STAGE_TIMES *add)
+{
+  QMutexLocker lock (&merge_mutex);
+
+  for (int32_t i = 0 ; i < STAGE_COUNT ; i++)
+    {
+      times->wall_ns[i] += add->wall_ns[i];
+      times->cpu_ns[i] += add->cpu_ns[i];
+      times->calls[i] += add->calls[i];
+      times->cells[i] += add->cells[i];
+    }
+}
+
+
+
+static void json_string (FILE *fp, const char *string)
+{
+  fputc ('"', fp);
+
+  for (const char *c = string ; *c ; c++)
+    {
+      if (*c == '"' || *c == '\\')
+        {
+          fprintf (fp, "\\%c", *c);
+        }
+      else if ((uint8_t) *c < 0x20)
+        {
+          fprintf (fp, "\\u%04x", (uint8_t) *c);
+        }
+      else
+        {
+          fputc (*c, fp);
+        }
+    }
+
+  fputc ('"', fp);
+}
+
+
+
+static double per_second (int64_t count, int64_t ns)
+{
+  if (ns <= 0) return (0.0);
+
+  return ((double) count / ((double) ns * 1.0e-9));
+}
+
+
+
+/*!
+    Write the times as JSON to report_file ("-" for stdout).  Returns NVFalse if the file couldn't be written.
+*/
+
+uint8_t stage_times_report (STAGE_TIMES *times, char *report_file, char *bag_file, char *output_file, int32_t width,
+                            int32_t height)
+{
+  FILE *fp = stdout;
+  int64_t cells = (int64_t) width * height;
+
+
+  if (strcmp (report_file, "-") && (fp = fopen (report_file, "w")) == NULL) return (NVFalse);
+
+  fprintf (fp, "{\n  \"bag_file\": ");
+  json_string (fp, bag_file);
+  fprintf (fp, ",\n  \"output_file\": ");
+  json_string (fp, output_file);
+  fprintf (fp, ",\n  \"width\": %d,\n  \"height\": %d,\n  \"cells\": %lld,\n", width, height, (long long) cells);
+  fprintf (fp, "  \"wall_seconds\": %.6f,\n  \"cpu_seconds\": %.6f,\n", times->total_wall_ns * 1.0e-9,
+           times->total_cpu_ns * 1.0e-9);
+  fprintf (fp, "  \"cells_per_second\": %.1f,\n", per_second (cells, times->total_wall_ns));
+  fprintf (fp, "  \"bytes_read\": %lld,\n  \"bytes_written\": %lld,\n  \"output_bytes\": %lld,\n",
+           (long long) times->bytes_read, (long long) times->bytes_written, (long long) times->output_bytes);
+  fprintf (fp, "  \"memory\": {\"budget\": %lld, \"peak_rss_kb\": %lld", (long long) times->memory.budget,
+           (long long) times->memory.peak_rss);
+  for (int32_t i = 0 ; i < MEMORY_PARTS ; i++)
+    fprintf (fp, ", \"%s\": %lld", memory_part_name (i), (long long) times->memory.bytes[i]);
+  fprintf (fp, "},\n");
+  if (times->lut_checked)
+    fprintf (fp, "  \"shade_lut\": {\"checked\": %lld, \"mismatches\": %lld, \"mismatch_rate\": %.6f},\n",
+             (long long) times->lut_checked, (long long) times->lut_mismatches,
+             (double) times->lut_mismatches / (double) times->lut_checked);
+  fprintf (fp, "  \"shade_in_colorize\": %s,\n  \"stages\": {\n", times->shade_in_color ? "true" : "false");
+
+  for (int32_t i = 0 ; i < STAGE_COUNT ; i++)
+    {
+      fprintf (fp, "    \"%s\": {\"calls\": %lld, \"wall_seconds\": %.6f, \"cpu_seconds\": %.6f, \"cells\": %lld, "
+               "\"cells_per_second\": %.1f}%s\n", stage_name[i], (long long) times->calls[i], times->wall_ns[i] * 1.0e-9,
+               times->cpu_ns[i] * 1.0e-9, (long long) times->cells[i], per_second (times->cells[i], times->wall_ns[i]),
+               (i < STAGE_COUNT - 1) ? "," : "");
+    }
+
+  fprintf (fp, "  }\n}\n");
+
+  if (fp == stdout)
+    {
+      fflush (fp);
+      return (NVTrue);
+    }
+
+  return (!fclose (fp));
+}
@@ -0,0 +1,106 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef STAGETIMER_H
+#define STAGETIMER_H
+
+#include "bagGeotiffDef.hpp"
+#include "memoryPlan.hpp"
+
+
+/*!
+    Stage instrumentation for bag_convert.  If CONVERT_PARAMS.timing points to a STAGE_TIMES structure the engine
+    adds up the wall clock and thread CPU time spent in each stage, the cells each stage handled, and the bytes read
+    and written.  If it's NULL (the default) none of the clocks are ever read.
+
+    The read, render (shade and colorize), and write stages run at the same time in the pipeline (pipeline.cpp) so
+    their wall times overlap.  The total wall time of the run is less than the sum of the stage times.  When
+    sunshade is called for every pixel (the row hillshade kernel isn't used) the shading can't be separated from
+    the coloring and it is all counted as colorize time.
+
+    stage_times_report writes it all out as JSON, along with the memory plan and peak resident set size, for
+    whatever wants to compare runs.
+*/
+
+
+#define         STAGE_OPEN                  0       //  Opening the BAG and the chunk aligned reader
+#define         STAGE_MINMAX                1       //  The min/max pass (including its reads)
+#define         STAGE_READ                  2       //  Reading area rows in the pipeline (HDF5 decompression or the row store)
+#define         STAGE_SHADE                 3       //  shade_span
+#define         STAGE_COLOR                 4       //  Palette lookup and pixel packing
+#define         STAGE_WRITE                 5       //  Handing the rows to the TIFF_WRITER (RasterIO, compression, overviews)
+#define         STAGE_CLOSE                 6       //  Flushing and closing the GeoTIFF (and the COG copy)
+
+#define         STAGE_COUNT                 7
+
+
+typedef struct
+{
+  int64_t       wall;                       //  Nanoseconds
+  int64_t       cpu;
+} STAGE_CLOCK;
+
+
+typedef struct
+{
+  int64_t       wall_ns[STAGE_COUNT];
+  int64_t       cpu_ns[STAGE_COUNT];
+  int64_t       calls[STAGE_COUNT];
+  int64_t       cells[STAGE_COUNT];
+  int64_t       bytes_read;                 //  Elevation bytes read from the BAG or the row store
+  int64_t       bytes_written;              //  Pixel bytes handed to the TIFF_WRITER
+  int64_t       output_bytes;               //  Size of the finished GeoTIFF
+  uint8_t       shade_in_color;             //  NVTrue if sunshade was called per pixel (shading is in STAGE_COLOR)
+  int64_t       lut_checked;                //  Cells compared with sunshade if the shade lookup table was used
+  int64_t       lut_mismatches;             //  Compared cells where the table gave a different shade level
+  int64_t       total_wall_ns;              //  Whole bag_convert call
+  int64_t       total_cpu_ns;               //  Process CPU time (all threads) for the whole call
+  MEMORY_PLAN   memory;                     //  Memory budget, what each buffer got, and the peak RSS (memoryPlan.hpp)
+} STAGE_TIMES;
+
+
+void stage_start (STAGE_CLOCK *clock);
+void stage_stop (STAGE_TIMES *times, int32_t stage, STAGE_CLOCK *clock, int64_t cells);
+void stage_times_start (STAGE_TIMES *times, STAGE_CLOCK *clock);
+void stage_times_stop (STAGE_TIMES *times, STAGE_CLOCK *clock);
+void stage_times_merge (STAGE_TIMES *times, STAGE_TIMES *add);
+uint8_t stage_times_report (STAGE_TIMES *times, char *report_file, char *bag_file, char *output_file, int32_t width,
+                            int32_t height);
+
+
+#endif
@@ -302,12 +302,6 @@ void startPage::slotOutputFileBrowse ()
 
 void startPage::slotAreaFileBrowse ()
 {
-  SHPHandle shpHandle;
-  SHPObject *shape = NULL;
-  int32_t type, numShapes;
-  double minBounds[4], maxBounds[4];
-
-
   QFileDialog *fd = new QFileDialog (this, tr ("bagGeotiff Area File"));
   fd->setViewMode (QFileDialog::List);
 
@@ -343,64 +337,34 @@ void startPage::slotAreaFileBrowse ()
               strcpy (shpname, area_file_name.toLatin1 ());
 
 
-              //  Open shape file
+              //  Read every part of every shape, the same way bag_convert will.
 
-              shpHandle = SHPOpen (shpname, "rb");
+              AREA_POLYGON area;
 
-              if (shpHandle == NULL)
-                {
-                  QMessageBox::warning (this, tr ("bagGeotiff"), tr ("Cannot open shape file %1!").arg (area_file_name));
-                  return;
-                }
-              else
+              if (!area_polygon_read (shpname, &area))
                 {
-                  //  Get shape file header info
-
-                  SHPGetInfo (shpHandle, &numShapes, &type, minBounds, maxBounds);
-
-
-                  if (type != SHPT_POLYGON && type != SHPT_POLYGONZ && type != SHPT_POLYGONM &&
-                      type != SHPT_ARC && type != SHPT_ARCZ && type != SHPT_ARCM)
+                  if (errno == EINVAL)
                     {
-                      QMessageBox::warning (this, tr ("bagGeotiff"), tr ("Shape file %1 is not a polygon or polyline file!").arg (area_file_name));
-                      return;
+                      QMessageBox::warning (this, tr ("bagGeotiff"), tr ("Shape file %1 has no polygon or polyline shapes with at least three vertices!").arg (area_file_name));
                     }
                   else
                     {
-                      //  Read only the first shape.
-
-                      shape = SHPReadObject (shpHandle, 0);
-
-
-                      //  Check the number of vertices.
-
-                      if (shape->nVertices < 3)
-                        {
-                          SHPClose (shpHandle);
-                          QMessageBox::warning (this, tr ("bagGeotiff"), tr ("Number of vertices (%1) of shape file %2 is too few for a polygon!").arg
-                                                (shape->nVertices).arg (area_file_name));
-                          return;
-                        }
-
-
-                      //  Read the vertices to take a shot at determining that this is a geographic polygon.
+                      QMessageBox::warning (this, tr ("bagGeotiff"), tr ("Cannot open shape file %1!").arg (area_file_name));
+                    }
+                  return;
+                }
 
-                      for (int32_t j = 0 ; j < shape->nVertices ; j++)
-                        {
-                          if (shape->padfX[j] < -360.0 || shape->padfX[j] > 360.0 || shape->padfY[j] < -90.0 || shape->padfY[j] > 90.0)
-                            {
-                              SHPDestroyObject (shape);
-                              SHPClose (shpHandle);
-                              QMessageBox::warning (this, tr ("bagGeotiff"), tr ("Shape file %1 does not appear to be geographic!").arg (area_file_name));
-                              return;
-                            }
-                        }
 
+              //  Check the vertices to take a shot at determining that this is a geographic polygon.
 
-                      SHPDestroyObject (shape);
-                      SHPClose (shpHandle);
-                    }
+              if (area.mbr.min_x < -360.0 || area.mbr.max_x > 360.0 || area.mbr.min_y < -90.0 || area.mbr.max_y > 90.0)
+                {
+                  area_polygon_free (&area);
+                  QMessageBox::warning (this, tr ("bagGeotiff"), tr ("Shape file %1 does not appear to be geographic!").arg (area_file_name));
+                  return;
                 }
+
+              area_polygon_free (&area);
             }
 
           area_file_edit->setText (area_file_name);
@@ -40,6 +40,7 @@
 #define STARTPAGE_H
 
 #include "bagGeotiffDef.hpp"
+#include "areaMask.hpp"
 
 
 class startPage:public QWizardPage
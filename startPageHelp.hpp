@@ -60,8 +60,8 @@ QString area_fileText =
                  "format (.are), the Army Corps area format (.afs), or ESRI shape file format.  Shape files must be "
                  "either Polygon, PolygonZ, PolygonM, PolyLine, PolyLineZ, or PolyLineM format and must be geographic "
                  "(not projected).  For PolyLine files the first point will be duplicated to close the polygon.  "
-                 "Whether using Polygon or PolyLine files, only the first shape will be used if there are multiple "
-                 "shapes in the file.<br><br>"
+                 "Every part of every shape in the file is used, with no limit on the number of vertices.  Holes "
+                 "(parts that go the other way around) are left out of the GeoTIFF.<br><br>"
                  "Generic area format files (.are) contain a simple list of polygon points.  The points may be in any of the "
                  "following formats:"
                  "<ul>"
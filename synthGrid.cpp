@@ -0,0 +1,229 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "synthGrid.hpp"
+
+
+static const char *type_name[SYNTH_TYPES] = {"smooth", "noisy", "nulls", "line"};
+
+
+//  Cell spacing of the synthetic grids, about 2 meters at the equator.
+
+#define         SYNTH_SPACING               0.000018
+
+
+
+const char *synth_type_name (int32_t type)
+{
+  if (type < 0 || type >= SYNTH_TYPES) return ("unknown");
+
+  return (type_name[type]);
+}
+
+
+
+//  Returns -1 if name isn't one of the types.
+
+int32_t synth_type (const char *name)
+{
+  for (int32_t i = 0 ; i < SYNTH_TYPES ; i++) if (!strcmp (name, type_name[i])) return (i);
+
+  return (-1);
+}
+
+
+
+//  Integer hash of a cell, used for the noise and the holes.
+
+static uint32_t cell_hash (uint32_t col, uint32_t row, uint32_t seed)
+{
+  uint32_t h = col * 0x8da6b343u ^ row * 0xd8163841u ^ seed * 0xcb1ab31fu;
+
+  h ^= h >> 13;
+  h *= 0x85ebca6bu;
+  h ^= h >> 16;
+
+  return (h);
+}
+
+
+
+static float smooth_elevation (SYNTH_GRID *grid, int32_t row, int32_t col)
+{
+  double u = (double) col / (double) grid->cols, v = (double) row / (double) grid->rows;
+
+  return ((float) (-90.0 + 80.0 * sin (u * 6.0 * M_PI) * cos (v * 4.0 * M_PI) + 30.0 * sin ((u + v) * 14.0 * M_PI) -
+                   20.0 * v));
+}
+
+
+
+//  Set up a CONVERT_SOURCE that reads grid.  The grid must stay around until bag_convert is done.
+
+void synth_grid_source (SYNTH_GRID *grid, CONVERT_SOURCE *source)
+{
+  memset (source, 0, sizeof (CONVERT_SOURCE));
+
+  source->cols = grid->cols;
+  source->rows = grid->rows;
+  source->x_spacing = SYNTH_SPACING;
+  source->y_spacing = SYNTH_SPACING;
+  source->sw_x = -70.0;
+  source->sw_y = 42.0;
+  source->min_elevation = -212.0;
+  source->max_elevation = 22.0;
+  source->read_row = synth_read_row;
+  source->user_data = (void *) grid;
+}
+
+
+
+uint8_t synth_read_row (int32_t row, int32_t col, int32_t width, float *data, void *user_data)
+{
+  SYNTH_GRID *grid = (SYNTH_GRID *) user_data;
+
+
+  if (row < 0 || row >= grid->rows || col < 0 || col + width > grid->cols) return (NVFalse);
+
+
+  //  The survey line runs corner to corner and is a fortieth of the grid wide.
+
+  double line_center = (double) row * (double) grid->cols / (double) grid->rows;
+  double line_half = qMax (2.0, grid->cols / 80.0);
+
+
+  for (int32_t j = 0 ; j < width ; j++)
+    {
+      int32_t c = col + j;
+      float z = smooth_elevation (grid, row, c);
+
+      switch (grid->type)
+        {
+        case SYNTH_LINE:
+          if (fabs ((double) c - line_center) > line_half)
+            {
+              z = NULL_ELEVATION;
+              break;
+            }
+
+          //  Fall through
+
+        case SYNTH_NOISY:
+          z += (float) (cell_hash (c, row, grid->seed) % 4001) * 0.001f - 2.0f;
+          break;
+
+        case SYNTH_NULLS:
+          if (cell_hash (c / 16, row / 16, grid->seed + 1) % 100 < 65 || cell_hash (c, row, grid->seed) % 100 < 5)
+            z = NULL_ELEVATION;
+          break;
+        }
+
+      data[j] = z;
+    }
+
+  return (NVTrue);
+}
+
+
+
+/*!
+    Read the sample data from the icons/data.dat resource (little endian 16 bit values, the southern row first).
+    min_val and max_val are left alone if the resource can't be opened.
+*/
+
+uint8_t sample_grid_read (int16_t data[SAMPLE_HEIGHT][SAMPLE_WIDTH], float *min_val, float *max_val)
+{
+  uint8_t idata[2];
+  QFile dataFile (":/icons/data.dat");
+
+
+  if (!dataFile.open (QIODevice::ReadOnly)) return (NVFalse);
+
+  *min_val = 99999.0;
+  *max_val = -99999.0;
+
+  for (int32_t i = 0 ; i < SAMPLE_HEIGHT ; i++)
+    {
+      for (int32_t j = 0 ; j < SAMPLE_WIDTH ; j++)
+        {
+          dataFile.read ((char *) idata, 2);
+          data[i][j] = idata[1] * 256 + idata[0];
+
+          *min_val = qMin ((float) data[i][j], *min_val);
+          *max_val = qMax ((float) data[i][j], *max_val);
+        }
+    }
+
+  dataFile.close ();
+
+  return (NVTrue);
+}
+
+
+
+//  Set up a CONVERT_SOURCE that reads the sample.  It must have been filled in by sample_grid_read.
+
+void sample_grid_source (SAMPLE_GRID *sample, CONVERT_SOURCE *source)
+{
+  memset (source, 0, sizeof (CONVERT_SOURCE));
+
+  source->cols = SAMPLE_WIDTH;
+  source->rows = SAMPLE_HEIGHT;
+  source->x_spacing = 185.0 / 111120.0;
+  source->y_spacing = 185.0 / 111120.0;
+  source->sw_x = 0.0;
+  source->sw_y = 0.0;
+  source->min_elevation = -sample->max_val;
+  source->max_elevation = -sample->min_val;
+  source->read_row = sample_read_row;
+  source->user_data = (void *) sample;
+}
+
+
+
+uint8_t sample_read_row (int32_t row, int32_t col, int32_t width, float *data, void *user_data)
+{
+  SAMPLE_GRID *sample = (SAMPLE_GRID *) user_data;
+
+
+  if (row < 0 || row >= SAMPLE_HEIGHT || col < 0 || col + width > SAMPLE_WIDTH) return (NVFalse);
+
+  for (int32_t j = 0 ; j < width ; j++) data[j] = -(float) sample->data[row][col + j];
+
+  return (NVTrue);
+}
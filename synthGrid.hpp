@@ -0,0 +1,94 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef SYNTHGRID_H
+#define SYNTHGRID_H
+
+#include "bagConvert.hpp"
+
+
+/*!
+    Synthetic elevation grids for benchmarking bag_convert (see bench.cpp) and checking its output (golden.cpp)
+    without having to carry big BAGs around.  Writing a real BAG needs a full set of ISO metadata so instead these are fed to the engine through a
+    CONVERT_SOURCE.  Every cell is a pure function of its row, column, and the seed so any row can be made on its
+    own, in any order, and the same grid comes out on every machine.
+
+    - SYNTH_SMOOTH  -  Rolling seafloor from about -200 to +20 meters (so the color map restarts at zero)
+    - SYNTH_NOISY   -  The smooth seafloor with +/- 2 meters of cell to cell noise (hard on LZW)
+    - SYNTH_NULLS   -  The smooth seafloor with about 70 percent of it missing in blocks, plus scattered holes
+    - SYNTH_LINE    -  A survey line, a narrow diagonal swath of the noisy seafloor with nothing on either side
+*/
+
+#define         SYNTH_SMOOTH                0
+#define         SYNTH_NOISY                 1
+#define         SYNTH_NULLS                 2
+#define         SYNTH_LINE                  3
+
+#define         SYNTH_TYPES                 4
+
+
+typedef struct
+{
+  int32_t       type;
+  int32_t       cols;
+  int32_t       rows;
+  uint32_t      seed;
+} SYNTH_GRID;
+
+
+//  The 130 by 200 sample in icons/data.dat that the image page shows, so it can be run through the engine too.
+//  The values are depths and the cells are 185 meters.
+
+typedef struct
+{
+  int16_t       data[SAMPLE_HEIGHT][SAMPLE_WIDTH];
+  float         min_val;
+  float         max_val;
+} SAMPLE_GRID;
+
+
+const char *synth_type_name (int32_t type);
+int32_t synth_type (const char *name);
+void synth_grid_source (SYNTH_GRID *grid, CONVERT_SOURCE *source);
+uint8_t synth_read_row (int32_t row, int32_t col, int32_t width, float *data, void *user_data);
+uint8_t sample_grid_read (int16_t data[SAMPLE_HEIGHT][SAMPLE_WIDTH], float *min_val, float *max_val);
+void sample_grid_source (SAMPLE_GRID *sample, CONVERT_SOURCE *source);
+uint8_t sample_read_row (int32_t row, int32_t col, int32_t width, float *data, void *user_data);
+
+
+#endif
@@ -0,0 +1,598 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+#include "tiffWriter.hpp"
+
+
+void set_tiff_defaults (TIFF_OPTIONS *options)
+{
+  options->mode = TIFF_STRIPPED;
+  options->tile_size = 256;
+  options->bigtiff = TIFF_BIGTIFF_DEFAULT;
+  options->predictor = 1;
+}
+
+
+
+static const char *bigtiff_name[4] = {"NO", "IF_NEEDED", "IF_SAFER", "YES"};
+
+
+
+//  Number of rows in the tile row buffer of overview level "level".
+
+static int32_t overview_buffer_height (TIFF_WRITER *writer, int32_t level)
+{
+  return (qMin (writer->options.tile_size, writer->ov[level].height));
+}
+
+
+
+//  Allocate empty internal overviews in the temporary COG file and the buffers we need to build them.
+
+static uint8_t open_overviews (TIFF_WRITER *writer)
+{
+  int32_t factors[MAX_OVERVIEWS], w = writer->width, h = writer->height, count = 0;
+
+
+  while (qMax (w, h) > writer->options.tile_size && count < MAX_OVERVIEWS)
+    {
+      w = (w + 1) / 2;
+      h = (h + 1) / 2;
+      factors[count] = 2 << count;
+      count++;
+    }
+
+  if (!count) return (NVTrue);
+
+
+  //  NONE resampling just allocates the overviews, we fill them ourselves as the rows come in.
+
+  if (writer->df->BuildOverviews ("NONE", count, factors, 0, NULL, NULL, NULL) == CE_Failure) return (NVFalse);
+
+
+  for (int32_t l = 0 ; l < count ; l++)
+    {
+      TIFF_OVERVIEW *ov = &writer->ov[l];
+
+      for (int32_t i = 0 ; i < writer->bands ; i++)
+        {
+          ov->bd[i] = writer->bd[i]->GetOverview (l);
+          if (ov->bd[i] == NULL) return (NVFalse);
+        }
+
+      ov->width = ov->bd[0]->GetXSize ();
+      ov->height = ov->bd[0]->GetYSize ();
+
+      writer->overviews++;
+
+      ov->pair = (uint8_t *) malloc ((l ? writer->ov[l - 1].width : writer->width) * writer->bands);
+      ov->buffer = (uint8_t *) malloc ((int64_t) overview_buffer_height (writer, l) * ov->width * writer->bands);
+
+      if (ov->pair == NULL || ov->buffer == NULL) return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+//  Bytes of tile row and overview buffers that tiff_writer_open will allocate for this output (not counting GDAL's
+//  own block cache).
+
+int64_t tiff_writer_memory (TIFF_OPTIONS *options, int32_t width, int32_t height, int32_t bands)
+{
+  int64_t bytes = 0;
+
+
+  if (options->mode != TIFF_TILED && options->mode != TIFF_COG) return (0);
+
+  bytes = (int64_t) qMin (options->tile_size, height) * width * bands;
+
+  if (options->mode == TIFF_COG)
+    {
+      int32_t w = width, h = height;
+
+      for (int32_t l = 0 ; l < MAX_OVERVIEWS && qMax (w, h) > options->tile_size ; l++)
+        {
+          bytes += (int64_t) w * bands;
+
+          w = (w + 1) / 2;
+          h = (h + 1) / 2;
+
+          bytes += (int64_t) qMin (options->tile_size, h) * w * bands;
+        }
+    }
+
+  return (bytes);
+}
+
+
+
+/*!
+    Create the GeoTIFF.  trans is the GDAL geotransform.  Returns NVFalse if the GTiff driver isn't available, the
+    file can't be created, or the buffers can't be allocated.
+*/
+
+uint8_t tiff_writer_open (TIFF_WRITER *writer, char *name, int32_t width, int32_t height, int32_t bands, double *trans,
+                          TIFF_OPTIONS *options)
+{
+  OGRSpatialReference ref;
+  char                *wkt = NULL, string[32];
+  GDALDriver          *gt;
+  char                **papszOptions = NULL;
+
+
+  memset (writer, 0, sizeof (TIFF_WRITER));
+
+  writer->width = width;
+  writer->height = height;
+  writer->bands = bands;
+  writer->options = *options;
+  strcpy (writer->name, name);
+
+
+  GDALAllRegister ();
+
+  gt = GetGDALDriverManager ()->GetDriverByName ("GTiff");
+  if (!gt) return (NVFalse);
+
+
+  int32_t bigtiff = options->bigtiff;
+
+  switch (options->mode)
+    {
+
+      //  Stupid Caris software can't read normal files!
+
+    case TIFF_CARIS:
+      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "PACKBITS");
+      if (bigtiff == TIFF_BIGTIFF_DEFAULT) bigtiff = TIFF_BIGTIFF_NO;
+      break;
+
+
+      //  The COG is written as a plain tiled file first and copied into COG layout when it's closed.
+
+    case TIFF_COG:
+      sprintf (writer->temp_name, "%s.cog.tmp", name);
+
+      //  Fall through
+
+    case TIFF_TILED:
+      sprintf (string, "%d", options->tile_size);
+      papszOptions = CSLSetNameValue (papszOptions, "TILED", "YES");
+      papszOptions = CSLSetNameValue (papszOptions, "BLOCKXSIZE", string);
+      papszOptions = CSLSetNameValue (papszOptions, "BLOCKYSIZE", string);
+      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "LZW");
+      if (bigtiff == TIFF_BIGTIFF_DEFAULT) bigtiff = TIFF_BIGTIFF_IF_SAFER;
+      writer->buffer_height = qMin (options->tile_size, height);
+      break;
+
+    default:
+      papszOptions = CSLSetNameValue (papszOptions, "TILED", "NO");
+      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "LZW");
+      break;
+    }
+
+  if (options->mode != TIFF_CARIS && options->predictor == 2) papszOptions = CSLSetNameValue (papszOptions, "PREDICTOR", "2");
+
+  if (bigtiff != TIFF_BIGTIFF_DEFAULT) papszOptions = CSLSetNameValue (papszOptions, "BIGTIFF", bigtiff_name[bigtiff]);
+
+  writer->options.bigtiff = bigtiff;
+
+
+  writer->df = gt->Create (writer->temp_name[0] ? writer->temp_name : name, width, height, bands, GDT_Byte, papszOptions);
+  CSLDestroy (papszOptions);
+
+  if (writer->df == NULL) return (NVFalse);
+
+
+  writer->df->SetGeoTransform (trans);
+  ref.SetWellKnownGeogCS ("EPSG:4326");
+  ref.exportToWkt (&wkt);
+  writer->df->SetProjection (wkt);
+  CPLFree (wkt);
+  for (int32_t i = 0 ; i < bands ; i++) writer->bd[i] = writer->df->GetRasterBand (i + 1);
+
+
+  if (writer->buffer_height)
+    {
+      writer->buffer = (uint8_t *) malloc ((int64_t) writer->buffer_height * width * bands);
+
+      if (writer->buffer == NULL)
+        {
+          tiff_writer_close (writer);
+          return (NVFalse);
+        }
+    }
+
+
+  if (options->mode == TIFF_COG && !open_overviews (writer))
+    {
+      tiff_writer_close (writer);
+      return (NVFalse);
+    }
+
+  return (NVTrue);
+}
+
+
+
+/*
+    Write num_rows pixel interleaved rows starting at row first_row of the full resolution image (level -1) or of
+    overview level "level".  The full resolution rows go in one dataset RasterIO call for all of the bands.  There
+    is no dataset for an overview so those are written a band at a time, picking the band out of the interleaved
+    rows with the pixel spacing.
+*/
+
+static void write_rows (TIFF_WRITER *writer, int32_t level, int32_t first_row, int32_t num_rows, uint8_t *data)
+{
+  CPLErr err = CE_None;
+  int32_t bands = writer->bands;
+
+
+  if (level < 0)
+    {
+      err = writer->df->RasterIO (GF_Write, 0, first_row, writer->width, num_rows, data, writer->width, num_rows, GDT_Byte,
+                                  bands, NULL, bands, (GSpacing) bands * writer->width, 1);
+    }
+  else
+    {
+      TIFF_OVERVIEW *ov = &writer->ov[level];
+
+      for (int32_t i = 0 ; i < bands ; i++)
+        {
+          if (ov->bd[i]->RasterIO (GF_Write, 0, first_row, ov->width, num_rows, &data[i], ov->width, num_rows, GDT_Byte, bands,
+                                   (GSpacing) bands * ov->width) == CE_Failure) err = CE_Failure;
+        }
+    }
+
+  if (err == CE_Failure)
+    {
+      writer->write_errors++;
+      writer->failed_row = first_row;
+    }
+}
+
+
+
+static void flush_buffer (TIFF_WRITER *writer)
+{
+  if (writer->buffer_rows)
+    {
+      write_rows (writer, -1, writer->buffer_start, writer->buffer_rows, writer->buffer);
+
+      writer->buffer_start += writer->buffer_rows;
+      writer->buffer_rows = 0;
+    }
+}
+
+
+
+static void flush_overview (TIFF_WRITER *writer, int32_t level)
+{
+  TIFF_OVERVIEW *ov = &writer->ov[level];
+
+  if (ov->buffer_rows)
+    {
+      write_rows (writer, level, ov->buffer_start, ov->buffer_rows, ov->buffer);
+
+      ov->buffer_start += ov->buffer_rows;
+      ov->buffer_rows = 0;
+    }
+}
+
+
+
+/*
+    Average the 2x2 blocks of the upper and lower rows (from the level above) into the next row of overview level
+    "level".  lower is NULL for a lone last row and the last column of an odd width row only has one column, so the
+    edges average whatever samples they have.  With an alpha band the colors are weighted by alpha so that the
+    transparent (no data) cells around the edge of the data don't darken the overviews.  The new row is then passed
+    on down to the next level.
+*/
+
+static void reduce_rows (TIFF_WRITER *writer, int32_t level, uint8_t *upper, uint8_t *lower)
+{
+  TIFF_OVERVIEW *ov = &writer->ov[level];
+  int32_t src_width = level ? writer->ov[level - 1].width : writer->width, bands = writer->bands;
+  uint8_t *rows[2] = {upper, lower}, *out;
+
+
+  //  Overview rows beyond the size GDAL gave the overview are dropped.
+
+  if (ov->buffer_start + ov->buffer_rows >= ov->height) return;
+
+
+  out = &ov->buffer[(int64_t) ov->buffer_rows * ov->width * bands];
+
+  for (int32_t c = 0 ; c < ov->width ; c++)
+    {
+      int32_t col[2] = {2 * c, qMin (2 * c + 1, src_width - 1)}, n = 0, sa = 0, sum[3] = {0, 0, 0};
+      uint8_t *pixel = &out[c * bands];
+
+      for (int32_t r = 0 ; r < 2 ; r++)
+        {
+          if (rows[r] == NULL) continue;
+
+          for (int32_t k = 0 ; k < 2 ; k++)
+            {
+              if (k && col[1] == col[0]) continue;
+
+              uint8_t *src = &rows[r][col[k] * bands];
+
+              n++;
+
+              if (bands == 4)
+                {
+                  sa += src[3];
+                  for (int32_t i = 0 ; i < 3 ; i++) sum[i] += src[i] * src[3];
+                }
+              else
+                {
+                  for (int32_t i = 0 ; i < 3 ; i++) sum[i] += src[i];
+                }
+            }
+        }
+
+      if (bands == 4)
+        {
+          if (sa)
+            {
+              for (int32_t i = 0 ; i < 3 ; i++) pixel[i] = (sum[i] + sa / 2) / sa;
+              pixel[3] = (sa + n / 2) / n;
+            }
+          else
+            {
+              for (int32_t i = 0 ; i < 4 ; i++) pixel[i] = 0;
+            }
+        }
+      else
+        {
+          for (int32_t i = 0 ; i < 3 ; i++) pixel[i] = (sum[i] + n / 2) / n;
+        }
+    }
+
+
+  //  Cascade the new row down before the buffer gets flushed and reused.
+
+  if (level + 1 < writer->overviews)
+    {
+      TIFF_OVERVIEW *next = &writer->ov[level + 1];
+
+      if (next->have_pair)
+        {
+          reduce_rows (writer, level + 1, next->pair, out);
+          next->have_pair = NVFalse;
+        }
+      else
+        {
+          memcpy (next->pair, out, ov->width * bands);
+          next->have_pair = NVTrue;
+        }
+    }
+
+
+  ov->buffer_rows++;
+
+  if (ov->buffer_rows == overview_buffer_height (writer, level)) flush_overview (writer, level);
+}
+
+
+
+/*!
+    Put num_rows rendered, pixel interleaved rows, starting at output row first_row, into the file.  The rows must
+    follow on from the last rows that were put.
+*/
+
+void tiff_writer_put_rows (TIFF_WRITER *writer, int32_t first_row, int32_t num_rows, uint8_t *pixels)
+{
+  QElapsedTimer timer;
+  int64_t row_bytes = (int64_t) writer->width * writer->bands;
+
+
+  timer.start ();
+
+  writer->next_row = first_row + num_rows;
+
+
+  //  Feed the rows into the first overview level a pair at a time.
+
+  if (writer->overviews)
+    {
+      TIFF_OVERVIEW *ov = &writer->ov[0];
+
+      for (int32_t t = 0 ; t < num_rows ; t++)
+        {
+          if (ov->have_pair)
+            {
+              reduce_rows (writer, 0, ov->pair, &pixels[t * row_bytes]);
+              ov->have_pair = NVFalse;
+            }
+          else
+            {
+              memcpy (ov->pair, &pixels[t * row_bytes], row_bytes);
+              ov->have_pair = NVTrue;
+            }
+        }
+    }
+
+
+  //  Write through if we're not buffering.
+
+  if (!writer->buffer_height)
+    {
+      write_rows (writer, -1, first_row, num_rows, pixels);
+    }
+
+
+  //  Otherwise copy the rows into the tile row buffer, writing it out every time it fills up.
+
+  else
+    {
+      for (int32_t t = 0 ; t < num_rows ; )
+        {
+          int32_t count = qMin (num_rows - t, writer->buffer_height - writer->buffer_rows);
+
+          memcpy (&writer->buffer[writer->buffer_rows * row_bytes], &pixels[t * row_bytes], count * row_bytes);
+
+          writer->buffer_rows += count;
+          t += count;
+
+          if (writer->buffer_rows == writer->buffer_height) flush_buffer (writer);
+        }
+    }
+
+  writer->write_time += (double) timer.nsecsElapsed () / 1.0e9;
+}
+
+
+
+//  Copy the finished temporary file into COG layout.  Returns NVFalse if neither driver could do it.
+
+static uint8_t copy_cog (TIFF_WRITER *writer)
+{
+  GDALDataset *src, *dst = NULL;
+  GDALDriver  *drv;
+  char        **papszOptions = NULL, string[32];
+
+
+  src = (GDALDataset *) GDALOpen (writer->temp_name, GA_ReadOnly);
+  if (src == NULL) return (NVFalse);
+
+  sprintf (string, "%d", writer->options.tile_size);
+
+
+  //  GDAL 3.1 and later have a COG driver that knows the layout rules.  OVERVIEWS=FORCE_USE_EXISTING keeps the
+  //  overviews we built instead of having it regenerate them from the full resolution data.
+
+  if ((drv = GetGDALDriverManager ()->GetDriverByName ("COG")) != NULL)
+    {
+      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "LZW");
+      papszOptions = CSLSetNameValue (papszOptions, "BLOCKSIZE", string);
+      papszOptions = CSLSetNameValue (papszOptions, "OVERVIEWS", "FORCE_USE_EXISTING");
+      if (writer->options.predictor == 2) papszOptions = CSLSetNameValue (papszOptions, "PREDICTOR", "YES");
+      papszOptions = CSLSetNameValue (papszOptions, "BIGTIFF", bigtiff_name[writer->options.bigtiff]);
+
+      dst = drv->CreateCopy (writer->name, src, FALSE, papszOptions, NULL, NULL);
+      CSLDestroy (papszOptions);
+      papszOptions = NULL;
+    }
+
+
+  //  Older GDAL, the GTiff driver puts the overviews first when asked to copy the source overviews.
+
+  if (dst == NULL && (drv = GetGDALDriverManager ()->GetDriverByName ("GTiff")) != NULL)
+    {
+      papszOptions = CSLSetNameValue (papszOptions, "TILED", "YES");
+      papszOptions = CSLSetNameValue (papszOptions, "BLOCKXSIZE", string);
+      papszOptions = CSLSetNameValue (papszOptions, "BLOCKYSIZE", string);
+      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "LZW");
+      papszOptions = CSLSetNameValue (papszOptions, "COPY_SRC_OVERVIEWS", "YES");
+      if (writer->options.predictor == 2) papszOptions = CSLSetNameValue (papszOptions, "PREDICTOR", "2");
+      papszOptions = CSLSetNameValue (papszOptions, "BIGTIFF", bigtiff_name[writer->options.bigtiff]);
+
+      dst = drv->CreateCopy (writer->name, src, FALSE, papszOptions, NULL, NULL);
+      CSLDestroy (papszOptions);
+    }
+
+  delete src;
+
+  if (dst == NULL) return (NVFalse);
+
+  delete dst;
+
+  return (NVTrue);
+}
+
+
+
+//  Flush anything left in the buffers and close the file.  For TIFF_COG this also makes the final COG file.
+
+void tiff_writer_close (TIFF_WRITER *writer)
+{
+  QElapsedTimer timer;
+
+
+  timer.start ();
+
+  if (writer->df)
+    {
+      flush_buffer (writer);
+
+
+      //  An odd number of rows leaves a lone row at the bottom of a level, average it by itself.
+
+      for (int32_t l = 0 ; l < writer->overviews ; l++)
+        {
+          if (writer->ov[l].have_pair)
+            {
+              reduce_rows (writer, l, writer->ov[l].pair, NULL);
+              writer->ov[l].have_pair = NVFalse;
+            }
+
+          flush_overview (writer, l);
+        }
+
+      delete writer->df;
+
+
+      //  Only bother making the COG if all of the rows made it.
+
+      if (writer->temp_name[0] && writer->next_row == writer->height && !copy_cog (writer))
+        {
+          writer->write_errors++;
+          writer->failed_row = -1;
+        }
+    }
+
+  writer->write_time += (double) timer.nsecsElapsed () / 1.0e9;
+
+  if (writer->temp_name[0]) remove (writer->temp_name);
+  writer->temp_name[0] = 0;
+
+  free (writer->buffer);
+  writer->buffer = NULL;
+
+  for (int32_t l = 0 ; l < MAX_OVERVIEWS ; l++)
+    {
+      free (writer->ov[l].pair);
+      free (writer->ov[l].buffer);
+      writer->ov[l].pair = writer->ov[l].buffer = NULL;
+    }
+
+  writer->overviews = 0;
+  writer->df = NULL;
+}
@@ -0,0 +1,143 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef TIFFWRITER_H
+#define TIFFWRITER_H
+
+#include "bagGeotiffDef.hpp"
+
+
+/*!
+    GeoTIFF output.  This handles creating the GDAL dataset with the right creation options for the output mode
+    and buffering the rendered rows so that they go to GDAL in the most efficient chunks for that mode.  Rows must
+    be put in order from the top (row 0) down.  Rows are pixel interleaved (RGBRGB... or RGBARGBA...), which is the
+    way GDAL's GTiff driver lays out a multi-band file (INTERLEAVE=PIXEL), so each chunk goes to GDAL in a single
+    GDALDataset::RasterIO call covering all of the bands instead of one call per band.
+
+    - TIFF_STRIPPED  -  LZW compressed, striped.  This is what bagGeotiff has always written.
+    - TIFF_CARIS     -  PACKBITS compressed.  The brain-dead Caris format.
+    - TIFF_TILED     -  LZW compressed with 256 or 512 internal tiles.  One tile row of output is buffered so
+                        that every tile is written whole, exactly once.
+    - TIFF_COG       -  Cloud Optimized GeoTIFF.  Tiled like TIFF_TILED, plus internal overviews.  The overviews
+                        are built from the rendered rows as they stream through (2x2 averages, cascading down
+                        the levels) so the full resolution data never has to be read back to make them.  The
+                        tiles and overviews are written to a temporary tiled GeoTIFF which is then copied into
+                        COG layout (overviews ahead of the full resolution data) with GDAL's COG driver, or with
+                        the GTiff driver and COPY_SRC_OVERVIEWS if the COG driver isn't available.  This is not
+                        a single pass.  GDAL can only lay out a COG in CreateCopy (GTiff's Create puts the tiles
+                        wherever they're written), so the copy re-reads and recompresses every tile, and the
+                        temporary file and the COG are both on disk until it's done.
+*/
+
+#define         TIFF_STRIPPED               0
+#define         TIFF_CARIS                  1
+#define         TIFF_TILED                  2
+#define         TIFF_COG                    3
+
+
+//  Maximum number of overview levels (each one is half the size of the one above it).
+
+#define         MAX_OVERVIEWS               16
+
+
+//  BIGTIFF creation option.  TIFF_BIGTIFF_DEFAULT means NO for the Caris format, IF_SAFER for tiled output, and
+//  leave it up to GDAL (IF_NEEDED) for striped output.
+
+#define         TIFF_BIGTIFF_DEFAULT        -1
+#define         TIFF_BIGTIFF_NO             0
+#define         TIFF_BIGTIFF_IF_NEEDED      1
+#define         TIFF_BIGTIFF_IF_SAFER       2
+#define         TIFF_BIGTIFF_YES            3
+
+
+typedef struct
+{
+  int32_t       mode;                       //  TIFF_STRIPPED, TIFF_CARIS, TIFF_TILED, or TIFF_COG
+  int32_t       tile_size;                  //  256 or 512, only used for TIFF_TILED and TIFF_COG
+  int32_t       bigtiff;                    //  One of the TIFF_BIGTIFF values above
+  int32_t       predictor;                  //  LZW predictor, 1 (none) or 2 (horizontal differencing)
+} TIFF_OPTIONS;
+
+
+//  One overview level being built.
+
+typedef struct
+{
+  GDALRasterBand *bd[4];
+  int32_t       width;
+  int32_t       height;
+  uint8_t       *pair;                      //  First row of the pair of rows from the level above
+  uint8_t       have_pair;
+  int32_t       buffer_start;               //  Same as the full resolution buffer in TIFF_WRITER
+  int32_t       buffer_rows;
+  uint8_t       *buffer;
+} TIFF_OVERVIEW;
+
+
+typedef struct
+{
+  GDALDataset   *df;
+  GDALRasterBand *bd[4];
+  int32_t       width;
+  int32_t       height;
+  int32_t       bands;
+  int32_t       buffer_height;              //  Rows in the buffer (tile_size for tiled, 0 means write through)
+  int32_t       buffer_start;               //  Output row of the first row in the buffer
+  int32_t       buffer_rows;                //  Number of rows in the buffer
+  uint8_t       *buffer;                    //  Pixel interleaved
+  int32_t       next_row;                   //  Next row we expect to be put
+  int32_t       write_errors;
+  int32_t       failed_row;                 //  Last output row that failed to write, -1 if the COG copy failed
+  TIFF_OPTIONS  options;
+  int32_t       overviews;                  //  Number of overview levels
+  TIFF_OVERVIEW ov[MAX_OVERVIEWS];
+  char          name[1024];                 //  Final output file name
+  char          temp_name[1024];            //  Temporary tiled file for TIFF_COG
+  double        write_time;                 //  Seconds spent in tiff_writer_put_rows and tiff_writer_close
+} TIFF_WRITER;
+
+
+void set_tiff_defaults (TIFF_OPTIONS *options);
+int64_t tiff_writer_memory (TIFF_OPTIONS *options, int32_t width, int32_t height, int32_t bands);
+uint8_t tiff_writer_open (TIFF_WRITER *writer, char *name, int32_t width, int32_t height, int32_t bands, double *trans,
+                          TIFF_OPTIONS *options);
+void tiff_writer_put_rows (TIFF_WRITER *writer, int32_t first_row, int32_t num_rows, uint8_t *pixels);
+void tiff_writer_close (TIFF_WRITER *writer);
+
+
+#endif
@@ -39,7 +39,7 @@
 
 #ifndef VERSION
 
-#define     VERSION     "PFM Software - bagGeotiff V1.11 - 08/07/19"
+#define     VERSION     "PFM Software - bagGeotiff V1.12 - 10/17/26"
 
 #endif
 
@@ -136,4 +136,86 @@
     - Now that get_area_mbr supports shape files we don't need to handle it differently from the other
       area file types.
 
+
+    Version 1.12
+    PFM Software
+    10/17/26
+
+    - Moved the conversion out of the wizard into a separate engine (bagConvert.cpp) and added a headless
+      command line mode (bagGeotiff --batch, see batch.cpp) that takes the same parameters as the wizard.
+    - Fixed the end column passed to bagReadRow when an area file starts east of the BAG's west edge.
+    - The BAG is now only read once.  The min/max pass keeps the rows in a bounded memory store that spills to a
+      temporary file (rowStore.cpp) and the render pass reads them back from there.  Optionally, the min/max
+      can be taken from the BAG elevation attributes instead.
+    - The colorize/sunshade loop has been moved to render.cpp and is run on bands of rows split across a
+      thread pool.  The output is identical to the single threaded version.
+    - The BAG elevation layer is now read in blocks of whole HDF5 chunk rows (bagReader.cpp) with a configurable
+      chunk cache so that each chunk is only decompressed once per pass.
+    - palshd can now also build a packed R, G, B, A byte palette.  The renderer uses that instead of calling the
+      QColor accessors for every pixel.
+    - Added a row at a time SSE/AVX2 hillshade kernel (shade.cpp) with a scalar fallback.  It is checked against
+      sunshade before each run and is only used if it matches.  bagGeotiff --batch --check_shade runs the check
+      over a range of sun options.  Since it only has to match within SHADE_TOLERANCE it can put a pixel one
+      shade level off now and then, so it's only used with --fast_shade.  The wizard always uses sunshade.
+    - Output now goes through a TIFF_WRITER (tiffWriter.cpp).  Added a tiled output mode (256 or 512 tiles, one
+      tile row buffered so tiles are written whole) and BIGTIFF and LZW predictor options.
+    - Added Cloud Optimized GeoTIFF output (bagGeotiff --batch --cog).  The internal overviews are built from the
+      rendered rows as they are written instead of by reading the finished file back.  GDAL can only make COG
+      layout with CreateCopy, so the tiles and overviews are copied from a temporary file at the end.  That copy
+      is a second pass over the output and needs about twice the disk space (see README.md).
+    - The renderer now produces pixel interleaved RGB(A) rows and the TIFF_WRITER writes them with one
+      GDALDataset::RasterIO call for all of the bands instead of one call per band.  The time spent writing is
+      reported in batch mode.
+    - Reading the BAG, rendering, and writing the GeoTIFF now run as a three stage pipeline (pipeline.cpp) with
+      the reader and writer in their own threads, so compression overlaps reading and rendering.  The number of
+      bands in flight is capped by a memory limit (bagGeotiff --batch --pipeline_memory).
+    - The wizard now runs the conversion in a separate thread (convertThread.cpp) with progress updates limited
+      to about 30 a second.  Cancel now works while converting.  It stops the conversion, closes the BAG and the
+      GeoTIFF, and removes the partial output file.
+    - bagGeotiff --batch can now convert a list, directory, or wildcard of BAGs (jobScheduler.cpp).  The BAGs
+      are converted by child processes run in parallel, with the cores split between files and render threads
+      by BAG size, and a per file summary (optionally CSV) is written at the end.
+    - Added a build cache for batch runs (--cache, buildCache.cpp).  BAGs whose GeoTIFFs were made from the same
+      BAG (path, size, and time, or just the MD5 of the contents with --cache_hash) with the same options, and
+      haven't been touched since, are skipped.  The MD5s are kept in the cache too and only worked out again for
+      BAGs whose size or time changed.
+    - The min, max, number of valid cells, and a depth histogram for each converted area are saved in a
+      BAG_FILE.stats sidecar (bagStats.cpp) if it can be written.  Reruns on an unchanged BAG (say with only the
+      sun or colors changed) skip the min/max pass unless --minmax=scan is given, and the image page shows the
+      depth range of the BAG if it has been converted before.  bagGeotiff --batch --no_stats turns it off.
+    - Cells inside the area file's bounding rectangle but outside of its polygon are now masked out
+      (areaMask.cpp, an edge table scanline rasterizer) and are skipped before any shading or coloring.
+    - Shape file areas now use every part of every shape (holes included, nonzero winding) with no limit on the
+      number of vertices.  The inside spans of each row are built once into a per row interval index.
+    - Added stage instrumentation (stageTimer.cpp).  bagGeotiff --batch --report=FILE writes a JSON report of
+      the wall and CPU time, cells, and cells per second of each stage plus the bytes read and written.  Nothing
+      is timed unless it's asked for.
+    - Added benchmarks (bagGeotiff --batch --bench, bench.cpp).  Synthetic smooth, noisy, mostly empty, and
+      survey line grids (synthGrid.cpp) are fed to the engine through a CONVERT_SOURCE and the throughput, peak
+      RSS, and output size of each are reported.
+    - Added golden image checks (bagGeotiff --batch --golden=FILE, golden.cpp).  The data.dat sample with each of
+      the image page color presets and the synthetic grids are rendered with fixed options, serially and threaded,
+      and the pixel hashes are compared with FILE (--golden_update writes it).  Without FILE the hashes committed
+      in icons/golden.txt are used.
+    - Added a memory budget (bagGeotiff --batch --memory=MB, memoryPlan.cpp).  The pipeline bands, read block,
+      HDF5 chunk cache, GDAL block cache, rows held in memory, and tile and overview buffers are all sized from
+      it so BAGs larger than RAM convert in a fixed amount of memory.  The memory plan and the peak resident set
+      size are printed in batch mode and included in the --report JSON.
+    - The image page now previews the selected BAG instead of the sample data.  The BAG is read once in the
+      background into a mean pooled pyramid (bagPyramid.cpp) and the level that fits the preview is rendered with
+      the same kernel as the GeoTIFF whenever a parameter changes.
+    - The sample data on the image page is now rendered into a QImage with the same kernel (render_image) as the
+      BAG preview and the GeoTIFF instead of a QPainter fillRect per pixel.  The sample now looks exactly like a
+      GeoTIFF of the sample data would.
+    - Image page parameter changes are now coalesced (a short timer restarts on every change) and the preview is
+      rendered in a background thread (renderThread.cpp).  A new render cancels the one in progress so only the
+      latest settings are ever finished.
+    - Palettes are now cached by saturation, value, and start and end hue (paletteCache.cpp, least recently used
+      thrown out first) so sun option changes never rebuild the palette.  The sample preset palettes are built
+      once at startup.  The QColor color array in OPTIONS is gone, everything uses the packed palette.
+    - Added --lut_shade.  The shade factor is looked up (bilinearly) in a table of quantized slopes built once per
+      sun and exaggeration setting (shade_lut_build in shade.cpp) instead of being computed for every pixel.  Every
+      16th row is checked against sunshade and the mismatch rate is printed and put in the --report JSON.
+      --check_shade reports the table mismatch rates too.
+
 </pre>*/